@@ -4,6 +4,13 @@
  Arithmetic in the finite field Fp, for prime p of fixed length using
  NTL as the backend.
 
+ Every operation installs the modulus of the field (see context()) with an
+ NTL::ZZ_pPush, and restores the caller's modulus on return. NTL keeps the
+ current modulus in thread-local storage, so field elements can be used
+ concurrently from different threads. The static parameters (s, t,
+ multiplicative_generator, root_of_unity, num_bits) must be set before any
+ concurrent use.
+
  *****************************************************************************
  * @author     Samir Menon, Brennan Shacklett, and David J. Wu
  * @copyright  MIT license (see LICENSE file)
@@ -47,7 +54,9 @@ public:
     NTLFp_model(const NTL::ZZ_p &value) : value(value) {}
 
     NTL::ZZ_p as_ZZ_p() const { return this->value; }
+    unsigned long as_ulong() const { return NTL::conv<unsigned long>(NTL::rep(this->value)); }
     static NTL::ZZ mod_zz() { return NTL::ZZ(modulus); }
+    static const NTL::ZZ_pContext& context();
 
     bool operator==(const NTLFp_model& other) const;
     bool operator!=(const NTLFp_model& other) const;
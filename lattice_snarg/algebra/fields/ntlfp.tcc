@@ -22,24 +22,28 @@
 
 namespace libsnark {
 
+template<unsigned long modulus>
+const NTL::ZZ_pContext& NTLFp_model<modulus>::context()
+{
+    static const NTL::ZZ_pContext ctx(mod_zz());
+    return ctx;
+}
+
 template<unsigned long modulus>
 NTLFp_model<modulus>::NTLFp_model()
 {
-    NTL::ZZ_p::init(mod_zz());
 }
 
 template<unsigned long modulus>
 NTLFp_model<modulus>::NTLFp_model(long x)
 {
-    NTL::ZZ_p::init(mod_zz());
+    NTL::ZZ_pPush push(context());
     this->value = x;
 }
 
 template <unsigned long modulus>
-NTLFp_model<modulus>::NTLFp_model(const NTLFp_model &other)
+NTLFp_model<modulus>::NTLFp_model(const NTLFp_model &other) : value(other.value)
 {
-    NTL::ZZ_p::init(mod_zz());
-    this->value = other.value;
 }
 
 template<unsigned long modulus>
@@ -69,7 +73,7 @@ void NTLFp_model<modulus>::print() const
 template<unsigned long modulus>
 NTLFp_model<modulus> NTLFp_model<modulus>::zero()
 {
-    NTL::ZZ_p::init(mod_zz());
+    NTL::ZZ_pPush push(context());
     NTLFp_model<modulus> z(NTL::ZZ_p::zero());
     return z;
 }
@@ -77,7 +81,7 @@ NTLFp_model<modulus> NTLFp_model<modulus>::zero()
 template<unsigned long modulus>
 NTLFp_model<modulus> NTLFp_model<modulus>::one()
 {
-    NTL::ZZ_p::init(mod_zz());
+    NTL::ZZ_pPush push(context());
     NTLFp_model<modulus> o(NTL::ZZ_p::zero() + 1);
     return o;
 }
@@ -85,7 +89,7 @@ NTLFp_model<modulus> NTLFp_model<modulus>::one()
 template<unsigned long modulus>
 NTLFp_model<modulus>& NTLFp_model<modulus>::operator+=(const NTLFp_model<modulus>& other)
 {
-    NTL::ZZ_p::init(mod_zz());
+    NTL::ZZ_pPush push(context());
     this->value += other.value;
     return *this;
 }
@@ -93,7 +97,7 @@ NTLFp_model<modulus>& NTLFp_model<modulus>::operator+=(const NTLFp_model<modulus
 template<unsigned long modulus>
 NTLFp_model<modulus>& NTLFp_model<modulus>::operator-=(const NTLFp_model<modulus>& other)
 {
-    NTL::ZZ_p::init(mod_zz());
+    NTL::ZZ_pPush push(context());
     this->value -= other.value;
     return *this;
 }
@@ -101,7 +105,7 @@ NTLFp_model<modulus>& NTLFp_model<modulus>::operator-=(const NTLFp_model<modulus
 template<unsigned long modulus>
 NTLFp_model<modulus>& NTLFp_model<modulus>::operator*=(const NTLFp_model<modulus>& other)
 {
-    NTL::ZZ_p::init(mod_zz());
+    NTL::ZZ_pPush push(context());
     this->value *= other.value;
     return *this;
 }
@@ -121,7 +125,7 @@ NTLFp_model<modulus>& NTLFp_model<modulus>::operator^=(const libff::bigint<1>& p
 template<unsigned long modulus>
 NTLFp_model<modulus>& NTLFp_model<modulus>::operator^=(const unsigned long pwr)
 {
-    NTL::ZZ_p::init(mod_zz());
+    NTL::ZZ_pPush push(context());
     this->value = NTL::power(this->value, pwr);
     return (*this);
 }
@@ -143,9 +147,9 @@ NTLFp_model<modulus> NTLFp_model<modulus>::operator-(const NTLFp_model<modulus>&
 template<unsigned long modulus>
 NTLFp_model<modulus> NTLFp_model<modulus>::operator*(const NTLFp_model<modulus>& other) const
 {
+    NTL::ZZ_pPush push(context());
     NTLFp_model<modulus> r;
     NTL::mul(r.value, value, other.value);
-    r.value = value * other.value;
     return r;
 }
 
@@ -173,6 +177,7 @@ NTLFp_model<modulus> NTLFp_model<modulus>::operator^(const libff::bigint<1>& pwr
 template<unsigned long modulus>
 NTLFp_model<modulus> NTLFp_model<modulus>::operator-() const
 {
+    NTL::ZZ_pPush push(context());
     NTLFp_model<modulus> r(modulus - this->value);
     return r;
 }
@@ -187,7 +192,8 @@ NTLFp_model<modulus> NTLFp_model<modulus>::squared() const
 template<unsigned long modulus>
 NTLFp_model<modulus>& NTLFp_model<modulus>::invert()
 {
-    NTL::ZZ_p inverse = 1 / this->value;;
+    NTL::ZZ_pPush push(context());
+    NTL::ZZ_p inverse = 1 / this->value;
     this->value = inverse;
     return *this;
 }
@@ -202,7 +208,7 @@ NTLFp_model<modulus> NTLFp_model<modulus>::inverse() const
 template<unsigned long modulus>
 NTLFp_model<modulus> NTLFp_model<modulus>::random_element()
 {
-    NTL::ZZ_p::init(mod_zz());
+    NTL::ZZ_pPush push(context());
     NTLFp_model<modulus> r;
     r.value = NTL::ZZ_p(NTL::RandomBnd(modulus));
     return r;
@@ -222,7 +228,7 @@ void NTLFp_model<modulus>::get_s_and_t(unsigned long& s, unsigned long& t)
 template<unsigned long modulus>
 NTLFp_model<modulus> NTLFp_model<modulus>::sqrt() const
 {
-    NTL::ZZ_p::init(mod_zz());
+    NTL::ZZ_pPush push(context());
     NTL::ZZ_p sqrt = NTL::to_ZZ_p(NTL::SqrRootMod(NTL::rep(this->value), mod_zz()));
     NTLFp_model<modulus> root;
     root.value = sqrt;
@@ -240,6 +246,7 @@ std::ostream& operator<<(std::ostream &out, const NTLFp_model<modulus> &p)
 template<unsigned long modulus>
 std::istream& operator>>(std::istream &in, NTLFp_model<modulus> &p)
 {
+    NTL::ZZ_pPush push(NTLFp_model<modulus>::context());
     in >> p.value;
     return in;
 }
@@ -14,10 +14,17 @@
 namespace libsnark {
 
 void lattice_pp::init_public_params() {
+#if defined(LWE_PARAMS_P31)
+  Fp_type::s = 27; // log2(modulus) OR modulus = 2^s * t + 1
+  Fp_type::t = 15; // with t odd
+  Fp_type::multiplicative_generator = Fp_type(31); // generator of Fp^*
+#else
   Fp_type::s = 16; // log2(modulus) OR modulus = 2^s * t + 1
   Fp_type::t = 1;  // with t odd
   Fp_type::multiplicative_generator = Fp_type(3); // generator of Fp^*
+#endif
   Fp_type::root_of_unity = Fp_type::multiplicative_generator^Fp_type::t; // generator^((modulus-1)/2^s)m
+  Fp_type::num_bits = NTL::NumBits(LWE::p);
 }
 
 }
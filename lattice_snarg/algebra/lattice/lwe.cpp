@@ -25,40 +25,108 @@ See lwe.hpp
 using namespace std;
 namespace LWE {
 
+const NTL::ZZ_pContext& q_context() {
+    static const NTL::ZZ_pContext context(q);
+    return context;
+}
+
+const NTL::ZZ_pContext& p_context() {
+    static const NTL::ZZ_pContext context(p);
+    return context;
+}
+
+// Per-thread stream of /dev/urandom
+static ifstream& urandom() {
+    static thread_local ifstream stream("/dev/urandom", ios::binary);
+    return stream;
+}
+
 static NTL::ZZ_p random(const NTL::ZZ &mod) {
     // Choose a random value from a space that is 128-bits
     // longer than the target space, and then round down.
 
     long num_bytes = NTL::NumBytes(mod) + 16;
     unsigned char bytes[num_bytes];
-    static ifstream urandom("/dev/urandom", ios::binary);
-    urandom.read(reinterpret_cast<char *>(bytes), num_bytes);
+    urandom().read(reinterpret_cast<char *>(bytes), num_bytes);
 
     NTL::ZZ randZZ = NTL::ZZFromBytes(bytes, num_bytes);
 
     return NTL::to_ZZ_p(randZZ % mod);
 }
 
+// Per-thread generator for the Gaussian samples, seeded from /dev/urandom
+// when the thread first samples
+static mt19937_64& gaussian_rng() {
+    static thread_local mt19937_64 rng = [] {
+        uint32_t seed[8];
+        urandom().read(reinterpret_cast<char *>(seed), sizeof(seed));
+        seed_seq seq(seed, seed + 8);
+        return mt19937_64(seq);
+    }();
+    return rng;
+}
+
 // Sample a discrete Gaussian variable using the Box-Muller
 // transform.
 static int32_t sample_discrete_gaussian(double stddev) {
     static const double PI = 4.0*atan(1.0);
 
-    double r1 = ((double) rand()) / RAND_MAX;
-    double r2 = ((double) rand()) / RAND_MAX;
+    // r1 in [0, 1) and r2 in (0, 1], so that log(r2) is finite
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    double r1 = uniform(gaussian_rng());
+    double r2 = 1.0 - uniform(gaussian_rng());
     double theta = 2*PI*r1;
 
     return (int32_t) floor(stddev * sqrt(-2.0*log(r2)) * cos(theta) + 0.5);
 }
 
+secret_key::secret_key() {
+    NTL::ZZ_pPush push(q_context());
+
+    A.SetDims(n + pt_dim, n);
+    S.SetDims(n + pt_dim, pt_dim);
+}
+
+secret_key::secret_key(const secret_key &other) {
+    NTL::ZZ_pPush push(q_context());
+
+    A = other.A;
+    S = other.S;
+}
+
+secret_key& secret_key::operator=(const secret_key &other) {
+    NTL::ZZ_pPush push(q_context());
+
+    A = other.A;
+    S = other.S;
+
+    return *this;
+}
+
+ciphertext::ciphertext(const ciphertext& other) {
+    NTL::ZZ_pPush push(q_context());
+
+    this->ctxt = other.ctxt;
+}
+
+ciphertext::ciphertext(ciphertext&& other) {
+    this->ctxt.swap(other.ctxt);
+}
+
 ciphertext& ciphertext::operator=(const ciphertext& other) {
-    NTL::ZZ_p::init(LWE::q);
+    NTL::ZZ_pPush push(q_context());
 
     this->ctxt = other.ctxt;
 
     return *this;
 }
 
+ciphertext& ciphertext::operator=(ciphertext&& other) {
+    this->ctxt.swap(other.ctxt);
+
+    return *this;
+}
+
 ciphertext ciphertext::operator+(const ciphertext &other) const {
     ciphertext sum = *this;
     sum += other;
@@ -67,13 +135,15 @@ ciphertext ciphertext::operator+(const ciphertext &other) const {
 }
 
 ciphertext& ciphertext::operator+=(const ciphertext &other) {
-    NTL::ZZ_p::init(LWE::q);
+    NTL::ZZ_pPush push(q_context());
 
     this->ctxt += other.ctxt;
     return *this;
 }
 
 ciphertext ciphertext::operator*(uint64_t val) const {
+    NTL::ZZ_pPush push(q_context());
+
     return operator*(NTL::ZZ_p(val));
 }
 
@@ -85,17 +155,21 @@ ciphertext ciphertext::operator*(const NTL::ZZ_p &val) const {
 }
 
 ciphertext& ciphertext::operator*=(uint64_t val) {
+    NTL::ZZ_pPush push(q_context());
+
     return operator*=(NTL::ZZ_p(val));
 }
 
 ciphertext& ciphertext::operator*=(const NTL::ZZ_p &val) {
-    NTL::ZZ_p::init(LWE::q);
+    NTL::ZZ_pPush push(q_context());
 
     this->ctxt *= val;
     return *this;
 }
 
 ciphertext operator*(uint64_t val, const ciphertext& ct) {
+    NTL::ZZ_pPush push(q_context());
+
     return operator*(NTL::ZZ_p(val), ct);
 }
 
@@ -107,7 +181,7 @@ ciphertext operator*(const NTL::ZZ_p &val, const ciphertext& ct) {
 }
 
 secret_key keygen() {
-    NTL::ZZ_p::init(LWE::q);
+    NTL::ZZ_pPush push(q_context());
     secret_key sk;
 
     // Sampled uniformly random matrix A
@@ -166,8 +240,8 @@ secret_key keygen() {
     return sk;
 }
 
-ciphertext encrypt(const secret_key &sk, const plaintext &pt) {
-    NTL::ZZ_p::init(LWE::q);
+ciphertext encrypt_zero(const secret_key &sk) {
+    NTL::ZZ_pPush push(q_context());
 
     // Sample an LWE error vector for the randomness (n x 1)
     vector r(NTL::INIT_SIZE, n);
@@ -175,17 +249,8 @@ ciphertext encrypt(const secret_key &sk, const plaintext &pt) {
         r(i) = sample_discrete_gaussian(stddev);  
     }
 
-    vector v_padded(NTL::INIT_SIZE, n + pt_dim);
-    for (size_t i = 1; i <= n; i++) {
-        v_padded(i) = 0;
-    }
-
-    for (size_t i = 1; i <= pt_dim; i++) {
-        v_padded(i + n) = pt(i);
-    }
-
     ciphertext ctxt;
-    ctxt.ctxt = sk.A*r + v_padded;
+    ctxt.ctxt = sk.A*r;
 
     // Add error to each component of ciphertext
     for (size_t i = 1; i <= n + pt_dim; i++) {
@@ -195,11 +260,27 @@ ciphertext encrypt(const secret_key &sk, const plaintext &pt) {
     return ctxt;
 }
 
+ciphertext encrypt(ciphertext &&zero, const plaintext &pt) {
+    NTL::ZZ_pPush push(q_context());
+
+    // Add the plaintext to the last pt_dim components
+    ciphertext ctxt(std::move(zero));
+    for (size_t i = 1; i <= pt_dim; i++) {
+        ctxt.ctxt(i + n) += pt(i);
+    }
+
+    return ctxt;
+}
+
+ciphertext encrypt(const secret_key &sk, const plaintext &pt) {
+    return encrypt(encrypt_zero(sk), pt);
+}
+
 plaintext decrypt(const secret_key &sk, const ciphertext& ct) {
-    NTL::ZZ_p::init(LWE::q);
+    NTL::ZZ_pPush push(q_context());
     vector modqvec = NTL::transpose(sk.S)*ct.ctxt;
 
-    NTL::ZZ_p::init(LWE::p);
+    p_context().restore();
     plaintext pt(NTL::INIT_SIZE, pt_dim);
     for (size_t i = 1; i <= pt_dim; i++) {
         NTL::ZZ modq = NTL::rep(modqvec(i));
@@ -214,4 +295,32 @@ plaintext decrypt(const secret_key &sk, const ciphertext& ct) {
     return pt;
 }
 
+std::ostream& operator<<(std::ostream &out, const ciphertext &ct) {
+    const long num_bytes = (log_q + 7) / 8;
+    unsigned char bytes[num_bytes];
+
+    assert(ct.ctxt.length() == n + pt_dim);
+    for (long i = 0; i < ct.ctxt.length(); i++) {
+        NTL::BytesFromZZ(bytes, NTL::rep(ct.ctxt[i]), num_bytes);
+        out.write(reinterpret_cast<const char *>(bytes), num_bytes);
+    }
+
+    return out;
+}
+
+std::istream& operator>>(std::istream &in, ciphertext &ct) {
+    NTL::ZZ_pPush push(q_context());
+
+    const long num_bytes = (log_q + 7) / 8;
+    unsigned char bytes[num_bytes];
+
+    ct.ctxt.SetLength(n + pt_dim);
+    for (long i = 0; i < ct.ctxt.length(); i++) {
+        in.read(reinterpret_cast<char *>(bytes), num_bytes);
+        NTL::conv(ct.ctxt[i], NTL::ZZFromBytes(bytes, num_bytes));
+    }
+
+    return in;
+}
+
 }
@@ -8,14 +8,22 @@
  - class for secret key
  - class for ciphertext
  - key generation algorithm
- - encryption algorithm
+ - encryption algorithm (also split into offline and online steps)
  - decryption algorithm
  - operations for homomorphic addition and scalar multiplication of ciphertexts
+   (see lwe_lincomb.hpp for linear combinations of many ciphertexts)
 
  The implementation instantiates (a modification of) the LWE-based cryptosystem
  from [LP10] (described in [Pei16, Section 5.2.3]). The implementation encodes
  the message in the low-order bits of the ciphertext.
 
+ Thread safety: NTL keeps the current ZZ_p modulus in thread-local storage
+ (NTL must be built with NTL_THREADS=on, the default). Every algorithm and
+ ciphertext operation below installs the modulus it needs from one of the
+ shared contexts q_context() and p_context() with an NTL::ZZ_pPush, and
+ restores the caller's modulus on return. Secret keys and ciphertexts can be
+ shared read-only between threads, and copied on any thread.
+
  References:
 
   [LP10]: Richard Lindner and Chris Peikert. Better Key Sizes (and Attacks) for
@@ -34,7 +42,11 @@
 #define LWE_HPP_
 
 #include <NTL/mat_ZZ_p.h>
+#include <cstdint>
+#include <iostream>
 #include <random>
+#include <vector>
+#include <lattice_snarg/common/numa_memory.hpp>
 #include "lwe_params.hpp"
 
 namespace LWE {
@@ -43,16 +55,38 @@ using matrix = NTL::mat_ZZ_p;
 using vector = NTL::vec_ZZ_p;
 using plaintext = vector;
 
+// Modulus contexts for Z_q (ciphertext space) and Z_p (plaintext space)
+const NTL::ZZ_pContext& q_context();
+const NTL::ZZ_pContext& p_context();
+
 class secret_key {
 public:
-    matrix A {NTL::INIT_SIZE, n + pt_dim, n};
-    matrix S {NTL::INIT_SIZE, n + pt_dim, pt_dim};
+    matrix A;
+    matrix S;
+
+    secret_key();
+    secret_key(const secret_key &other);
+    secret_key& operator=(const secret_key &other);
 };
 
+class lincomb_plan;
+class processed_secret_key;
+class packed_ciphertexts;
+class ciphertext;
+
+ciphertext linear_combination(const std::vector<ciphertext> &cts,
+                              const std::vector<uint64_t> &coeffs,
+                              const lincomb_plan &plan);
+
 class ciphertext {
 public:
-  // Assignment operator
+  ciphertext() = default;
+  ciphertext(const ciphertext& other);
+  ciphertext(ciphertext&& other);
+
+  // Assignment operators
   ciphertext& operator=(const ciphertext& other);
+  ciphertext& operator=(ciphertext&& other);
 
   // Homomorphic addition
   ciphertext operator+(const ciphertext &other) const;
@@ -67,17 +101,38 @@ public:
 private:
   vector ctxt;
 
-friend ciphertext encrypt(const secret_key &sk, const plaintext &pt);
+friend ciphertext encrypt_zero(const secret_key &sk);
+friend ciphertext encrypt(ciphertext &&zero, const plaintext &pt);
 friend plaintext  decrypt(const secret_key &sk, const ciphertext &ct);
+friend ciphertext linear_combination(const std::vector<ciphertext> &cts,
+                                     const std::vector<uint64_t> &coeffs,
+                                     const lincomb_plan &plan);
+friend void decrypt(const processed_secret_key &psk, const ciphertext &ct, uint64_t *pt);
+friend packed_ciphertexts pack_ciphertexts(const std::vector<ciphertext> &cts, libsnark::huge_pages pages, int node);
+friend ciphertext linear_combination(const packed_ciphertexts &cts, const std::vector<uint64_t> &coeffs,
+                                     size_t tile_words, size_t num_threads);
+friend std::ostream& operator<<(std::ostream &out, const ciphertext &ct);
+friend std::istream& operator>>(std::istream &in, ciphertext &ct);
 };
 
 secret_key keygen();
 ciphertext encrypt(const secret_key &sk, const plaintext &pt);
+
+// Encryption in two steps: encrypt_zero does all the work that does not depend
+// on the plaintext (sampling the randomness, and computing A*r plus noise);
+// encrypt then adds the plaintext to an (unused) encryption of zero. See
+// lwe_pool.hpp for a pool of precomputed encryptions of zero.
+ciphertext encrypt_zero(const secret_key &sk);
+ciphertext encrypt(ciphertext &&zero, const plaintext &pt);
 plaintext  decrypt(const secret_key &sk, const ciphertext &ct);
 
 ciphertext operator*(uint64_t val, const ciphertext& ct);
 ciphertext operator*(const NTL::ZZ_p &val, const ciphertext& ct);
 
+// Binary serialization: n + pt_dim little-endian words of ceil(log_q / 8) bytes
+std::ostream& operator<<(std::ostream &out, const ciphertext &ct);
+std::istream& operator>>(std::istream &in, ciphertext &ct);
+
 }
 
 #endif // LWE_HPP_
@@ -0,0 +1,360 @@
+/** @file
+*****************************************************************************
+
+Implementation of runtime-dispatched arithmetic kernels: the ntl and native
+backends, backend selection, and cross-checking.
+
+See lwe_kernels.hpp
+
+*****************************************************************************
+* @author     Samir Menon, Brennan Shacklett, and David J. Wu
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "lwe_kernels.hpp"
+#include "lwe_kernels_simd.hpp"
+#include "lwe_tuning.hpp"
+
+namespace LWE {
+
+const char* backend_name(backend b) {
+    switch (b) {
+        case backend::ntl:    return "ntl";
+        case backend::native: return "native";
+        case backend::avx2:   return "avx2";
+        case backend::avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+/********************************* ntl backend *******************************/
+
+static void mul_add_ntl(word *acc, const word *row, uint64_t c, size_t len) {
+    NTL::ZZ_pPush push(q_context());
+    const NTL::ZZ_p cc = NTL::conv<NTL::ZZ_p>((long) c);
+
+    NTL::ZZ_p a, r;
+    for (size_t k = 0; k < len; k++) {
+        NTL::conv(a, from_word(acc[k] & q_mask));
+        NTL::conv(r, from_word(row[k] & q_mask));
+        NTL::mul(r, r, cc);
+        NTL::add(a, a, r);
+        acc[k] = to_word(NTL::rep(a));
+    }
+}
+
+static void add_ntl(word *acc, const word *row, size_t len) {
+    mul_add_ntl(acc, row, 1, len);
+}
+
+static word dot_ntl(const word *x, const word *y, size_t len) {
+    NTL::ZZ_pPush push(q_context());
+
+    NTL::ZZ_p sum(0), a, b;
+    for (size_t k = 0; k < len; k++) {
+        NTL::conv(a, from_word(x[k] & q_mask));
+        NTL::conv(b, from_word(y[k] & q_mask));
+        NTL::mul(a, a, b);
+        NTL::add(sum, sum, a);
+    }
+    return to_word(NTL::rep(sum));
+}
+
+static uint64_t dot_mod_p_ntl(const uint32_t *M, const uint64_t *x, size_t len) {
+    NTL::ZZ_pPush push(p_context());
+
+    NTL::ZZ_p sum(0), a, b;
+    for (size_t k = 0; k < len; k++) {
+        NTL::conv(a, (long) M[k]);
+        NTL::conv(b, (long) x[k]);
+        NTL::mul(a, a, b);
+        NTL::add(sum, sum, a);
+    }
+    return NTL::conv<unsigned long>(NTL::rep(sum));
+}
+
+/******************************* native backend ******************************/
+
+static void mul_add_native(word *acc, const word *row, uint64_t c, size_t len) {
+    // Arithmetic modulo 2^(8*sizeof(word)), which is a multiple of q
+    const word cw = c;
+    for (size_t k = 0; k < len; k++) {
+        acc[k] += cw * row[k];
+    }
+}
+
+static void add_native(word *acc, const word *row, size_t len) {
+    for (size_t k = 0; k < len; k++) {
+        acc[k] += row[k];
+    }
+}
+
+static word dot_native(const word *x, const word *y, size_t len) {
+    word sum = 0;
+    for (size_t k = 0; k < len; k++) {
+        sum += x[k] * y[k];
+    }
+    return sum;
+}
+
+static uint64_t dot_mod_p_native(const uint32_t *M, const uint64_t *x, size_t len) {
+    uint64_t acc = 0;
+    size_t k = 0;
+    while (k < len) {
+        const size_t end = std::min<size_t>(len, k + lazy_reduction_batch);
+        for (; k < end; k++) {
+            acc += M[k] * x[k];
+        }
+        acc %= p_int;
+    }
+    return acc;
+}
+
+/******************************** SIMD backends ******************************/
+
+// The SIMD kernels operate on 64-bit words, and are only available if
+// sizeof(word) == 8
+
+static void mul_add_avx2_word(word *acc, const word *row, uint64_t c, size_t len) {
+    mul_add_avx2(reinterpret_cast<uint64_t *>(acc), reinterpret_cast<const uint64_t *>(row), c, len);
+}
+
+static void add_avx2_word(word *acc, const word *row, size_t len) {
+    add_avx2(reinterpret_cast<uint64_t *>(acc), reinterpret_cast<const uint64_t *>(row), len);
+}
+
+static word dot_avx2_word(const word *x, const word *y, size_t len) {
+    return dot_avx2(reinterpret_cast<const uint64_t *>(x), reinterpret_cast<const uint64_t *>(y), len);
+}
+
+static uint64_t dot_mod_p_avx2_word(const uint32_t *M, const uint64_t *x, size_t len) {
+    return dot_mod_p_avx2(M, x, len, p_int, lazy_reduction_batch);
+}
+
+static void mul_add_avx512_word(word *acc, const word *row, uint64_t c, size_t len) {
+    mul_add_avx512(reinterpret_cast<uint64_t *>(acc), reinterpret_cast<const uint64_t *>(row), c, len);
+}
+
+static void add_avx512_word(word *acc, const word *row, size_t len) {
+    add_avx512(reinterpret_cast<uint64_t *>(acc), reinterpret_cast<const uint64_t *>(row), len);
+}
+
+static word dot_avx512_word(const word *x, const word *y, size_t len) {
+    return dot_avx512(reinterpret_cast<const uint64_t *>(x), reinterpret_cast<const uint64_t *>(y), len);
+}
+
+static uint64_t dot_mod_p_avx512_word(const uint32_t *M, const uint64_t *x, size_t len) {
+    return dot_mod_p_avx512(M, x, len, p_int, lazy_reduction_batch);
+}
+
+static const kernel_table ntl_kernels = { backend::ntl, mul_add_ntl, add_ntl, dot_ntl, dot_mod_p_ntl };
+static const kernel_table native_kernels = { backend::native, mul_add_native, add_native, dot_native, dot_mod_p_native };
+static const kernel_table avx2_kernels = { backend::avx2, mul_add_avx2_word, add_avx2_word, dot_avx2_word, dot_mod_p_avx2_word };
+static const kernel_table avx512_kernels = { backend::avx512, mul_add_avx512_word, add_avx512_word, dot_avx512_word, dot_mod_p_avx512_word };
+
+/********************************** Selection ********************************/
+
+static bool cpu_supports(backend b) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    switch (b) {
+        case backend::avx2:   return __builtin_cpu_supports("avx2");
+        case backend::avx512: return __builtin_cpu_supports("avx512f");
+        default:              return true;
+    }
+#else
+    return (b == backend::ntl || b == backend::native);
+#endif
+}
+
+bool backend_available(backend b) {
+    switch (b) {
+        case backend::ntl:
+        case backend::native:
+            return true;
+        case backend::avx2:
+            return sizeof(word) == sizeof(uint64_t) && simd_avx2_compiled && cpu_supports(b);
+        case backend::avx512:
+            return sizeof(word) == sizeof(uint64_t) && simd_avx512_compiled && cpu_supports(b);
+    }
+    return false;
+}
+
+const kernel_table& kernels(backend b) {
+    assert(backend_available(b));
+    switch (b) {
+        case backend::ntl:    return ntl_kernels;
+        case backend::native: return native_kernels;
+        case backend::avx2:   return avx2_kernels;
+        case backend::avx512: return avx512_kernels;
+    }
+    return native_kernels;
+}
+
+// The backend named by LATTICE_SNARG_BACKEND, or by the tuning profile, or the
+// fastest available one
+static const kernel_table& initial_kernels() {
+    const backend all[] = { backend::ntl, backend::native, backend::avx2, backend::avx512 };
+
+    const char *name = getenv("LATTICE_SNARG_BACKEND");
+    if (name != nullptr && strcmp(name, "auto") != 0 && strcmp(name, "") != 0) {
+        bool known = false;
+        for (backend b : all) {
+            if (strcmp(name, backend_name(b)) == 0) {
+                if (backend_available(b)) {
+                    return kernels(b);
+                }
+                fprintf(stderr, "LATTICE_SNARG_BACKEND: backend %s is not available on this host\n", name);
+                known = true;
+            }
+        }
+        if (!known) {
+            fprintf(stderr, "LATTICE_SNARG_BACKEND: unknown backend %s\n", name);
+        }
+    }
+
+    const tuning_profile &profile = active_tuning_profile();
+    if (profile.has_backend) {
+        if (backend_available(profile.kernel_backend)) {
+            return kernels(profile.kernel_backend);
+        }
+        fprintf(stderr, "LATTICE_SNARG_PROFILE: backend %s is not available on this host\n", backend_name(profile.kernel_backend));
+    }
+
+    if (backend_available(backend::avx512)) {
+        return avx512_kernels;
+    } else if (backend_available(backend::avx2)) {
+        return avx2_kernels;
+    }
+    return native_kernels;
+}
+
+static std::atomic<const kernel_table*> selected(nullptr);
+
+static const kernel_table& selected_kernels() {
+    static const kernel_table &initial = initial_kernels();
+    const kernel_table *k = selected.load(std::memory_order_acquire);
+    return (k != nullptr) ? *k : initial;
+}
+
+backend active_backend() {
+    return selected_kernels().id;
+}
+
+bool set_backend(backend b) {
+    if (!backend_available(b)) {
+        return false;
+    }
+    selected.store(&kernels(b), std::memory_order_release);
+    return true;
+}
+
+/******************************* Cross-checking ******************************/
+
+static void mismatch(const char *kernel) {
+    fprintf(stderr, "LATTICE_SNARG_BACKEND_CHECK: %s kernel of the %s backend differs from the ntl backend\n",
+            kernel, backend_name(selected_kernels().id));
+    abort();
+}
+
+static void mul_add_checked(word *acc, const word *row, uint64_t c, size_t len) {
+    std::vector<word> expected(acc, acc + len);
+    ntl_kernels.mul_add(expected.data(), row, c, len);
+    selected_kernels().mul_add(acc, row, c, len);
+    for (size_t k = 0; k < len; k++) {
+        if (((acc[k] ^ expected[k]) & q_mask) != 0) {
+            mismatch("mul_add");
+        }
+    }
+}
+
+static void add_checked(word *acc, const word *row, size_t len) {
+    std::vector<word> expected(acc, acc + len);
+    ntl_kernels.add(expected.data(), row, len);
+    selected_kernels().add(acc, row, len);
+    for (size_t k = 0; k < len; k++) {
+        if (((acc[k] ^ expected[k]) & q_mask) != 0) {
+            mismatch("add");
+        }
+    }
+}
+
+static word dot_checked(const word *x, const word *y, size_t len) {
+    const word result = selected_kernels().dot(x, y, len);
+    if (((result ^ ntl_kernels.dot(x, y, len)) & q_mask) != 0) {
+        mismatch("dot");
+    }
+    return result;
+}
+
+static uint64_t dot_mod_p_checked(const uint32_t *M, const uint64_t *x, size_t len) {
+    const uint64_t result = selected_kernels().dot_mod_p(M, x, len);
+    if (result != ntl_kernels.dot_mod_p(M, x, len)) {
+        mismatch("dot_mod_p");
+    }
+    return result;
+}
+
+static const kernel_table checked_kernels = { backend::ntl, mul_add_checked, add_checked, dot_checked, dot_mod_p_checked };
+
+static bool check_enabled() {
+    static const bool enabled = (getenv("LATTICE_SNARG_BACKEND_CHECK") != nullptr &&
+                                 strcmp(getenv("LATTICE_SNARG_BACKEND_CHECK"), "0") != 0);
+    return enabled;
+}
+
+const kernel_table& kernels() {
+    return check_enabled() ? checked_kernels : selected_kernels();
+}
+
+bool cross_check_backend(backend b, size_t trials) {
+    if (!backend_available(b)) {
+        return false;
+    }
+
+    const kernel_table &fast = kernels(b);
+    std::mt19937_64 rng(trials);
+    bool ok = true;
+
+    for (size_t t = 0; t < trials; t++) {
+        // Lengths around the vector widths, and up to a ciphertext
+        const size_t len = (t < 18) ? t : (size_t) (rng() % (2 * ct_dim));
+
+        std::vector<word> x(len), y(len), acc(len);
+        std::vector<uint32_t> M(len);
+        std::vector<uint64_t> v(len);
+        for (size_t k = 0; k < len; k++) {
+            x[k] = (word) rng() << 32 ^ rng();
+            y[k] = (word) rng() << 32 ^ rng();
+            acc[k] = (word) rng() << 32 ^ rng();
+            M[k] = (uint32_t) (rng() % p_int);
+            v[k] = rng() % p_int;
+        }
+        const uint64_t c = (t % 3 == 0) ? p_int - 1 : rng() % p_int;
+
+        std::vector<word> acc_fast(acc), acc_ntl(acc);
+        fast.mul_add(acc_fast.data(), x.data(), c, len);
+        ntl_kernels.mul_add(acc_ntl.data(), x.data(), c, len);
+        fast.add(acc_fast.data(), y.data(), len);
+        ntl_kernels.add(acc_ntl.data(), y.data(), len);
+        for (size_t k = 0; k < len; k++) {
+            ok = ok && ((acc_fast[k] ^ acc_ntl[k]) & q_mask) == 0;
+        }
+
+        ok = ok && ((fast.dot(x.data(), y.data(), len) ^ ntl_kernels.dot(x.data(), y.data(), len)) & q_mask) == 0;
+        ok = ok && fast.dot_mod_p(M.data(), v.data(), len) == ntl_kernels.dot_mod_p(M.data(), v.data(), len);
+    }
+
+    return ok;
+}
+
+}
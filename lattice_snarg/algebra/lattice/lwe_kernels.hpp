@@ -0,0 +1,103 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of runtime-dispatched arithmetic kernels for the native-word
+ layouts of the lattice-based vector encryption scheme (see lwe_native.hpp).
+
+ Each backend implements the same kernels:
+ - ntl:    reference implementation through NTL (slow; for cross-checking)
+ - native: portable 64-bit (or 128-bit) integer arithmetic
+ - avx2:   AVX2 vector kernels
+ - avx512: AVX-512F vector kernels
+ The vector backends are compiled into every binary, and are available if the
+ CPU supports them (CPUID) and elements of Z_q fit in 64-bit words (so, not
+ with LWE_PARAMS_P31).
+
+ The active backend is the fastest available one, unless overridden with the
+ environment variable LATTICE_SNARG_BACKEND (ntl, native, avx2, avx512 or
+ auto) or with set_backend(). If the environment variable
+ LATTICE_SNARG_BACKEND_CHECK is set (to anything but 0), every kernel call is
+ also evaluated with the ntl backend, and the process aborts on a mismatch.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef LWE_KERNELS_HPP_
+#define LWE_KERNELS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "lwe_native.hpp"
+
+namespace LWE {
+
+enum class backend {
+    ntl,
+    native,
+    avx2,
+    avx512
+};
+
+const char* backend_name(backend b);
+
+/**
+ * The kernels of a backend. Results on elements of Z_q are only defined modulo
+ * q (callers reduce with q_mask).
+ */
+class kernel_table {
+public:
+    backend id;
+
+    // acc[k] += c * row[k] for k < len, with c < p
+    void (*mul_add)(word *acc, const word *row, uint64_t c, size_t len);
+
+    // acc[k] += row[k] for k < len
+    void (*add)(word *acc, const word *row, size_t len);
+
+    // sum_k x[k] * y[k]
+    word (*dot)(const word *x, const word *y, size_t len);
+
+    // sum_k M[k] * x[k] mod p, with M[k] < p and x[k] < p
+    uint64_t (*dot_mod_p)(const uint32_t *M, const uint64_t *x, size_t len);
+};
+
+/**
+ * Whether backend b is compiled in and supported by the CPU.
+ */
+bool backend_available(backend b);
+
+/**
+ * The kernels of backend b, which must be available.
+ */
+const kernel_table& kernels(backend b);
+
+/**
+ * The kernels of the active backend.
+ */
+const kernel_table& kernels();
+
+/**
+ * The active backend. With LATTICE_SNARG_BACKEND_CHECK set, kernels() wraps
+ * it in cross-checked kernels (whose id is ntl); this is the backend they
+ * check.
+ */
+backend active_backend();
+
+/**
+ * Select the active backend. Returns false (and leaves the active backend
+ * unchanged) if b is not available.
+ */
+bool set_backend(backend b);
+
+/**
+ * Compare the kernels of backend b with the ntl backend on trials random
+ * inputs of various lengths. Returns false on a mismatch.
+ */
+bool cross_check_backend(backend b, size_t trials = 16);
+
+}
+
+#endif // LWE_KERNELS_HPP_
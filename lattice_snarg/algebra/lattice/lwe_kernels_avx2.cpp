@@ -0,0 +1,128 @@
+/** @file
+*****************************************************************************
+
+Implementation of the AVX2 kernels.
+
+See lwe_kernels_simd.hpp
+
+*****************************************************************************
+* @author     Samir Menon, Brennan Shacklett, and David J. Wu
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+#include <cstdlib>
+
+#include "lwe_kernels_simd.hpp"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace LWE {
+
+#ifdef __AVX2__
+
+const bool simd_avx2_compiled = true;
+
+// Low 64 bits of the lane-wise products x * y
+static inline __m256i mullo_epi64(__m256i x, __m256i y) {
+    const __m256i lo = _mm256_mul_epu32(x, y);
+    const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(x, _mm256_srli_epi64(y, 32)),
+                                           _mm256_mul_epu32(_mm256_srli_epi64(x, 32), y));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+static inline uint64_t hsum_epi64(__m256i x) {
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), x);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+void mul_add_avx2(uint64_t *acc, const uint64_t *row, uint64_t c, size_t len) {
+    // c < 2^32, so c * row[k] = c * lo(row[k]) + 2^32 * c * hi(row[k])
+    const __m256i vc = _mm256_set1_epi64x(c);
+
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + k));
+        const __m256i lo = _mm256_mul_epu32(r, vc);
+        const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(r, 32), vc);
+        const __m256i prod = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+
+        __m256i *a = reinterpret_cast<__m256i *>(acc + k);
+        _mm256_storeu_si256(a, _mm256_add_epi64(_mm256_loadu_si256(a), prod));
+    }
+    for (; k < len; k++) {
+        acc[k] += c * row[k];
+    }
+}
+
+void add_avx2(uint64_t *acc, const uint64_t *row, size_t len) {
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + k));
+        __m256i *a = reinterpret_cast<__m256i *>(acc + k);
+        _mm256_storeu_si256(a, _mm256_add_epi64(_mm256_loadu_si256(a), r));
+    }
+    for (; k < len; k++) {
+        acc[k] += row[k];
+    }
+}
+
+uint64_t dot_avx2(const uint64_t *x, const uint64_t *y, size_t len) {
+    __m256i sum = _mm256_setzero_si256();
+
+    size_t k = 0;
+    for (; k + 4 <= len; k += 4) {
+        const __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + k));
+        const __m256i vy = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + k));
+        sum = _mm256_add_epi64(sum, mullo_epi64(vx, vy));
+    }
+
+    uint64_t result = hsum_epi64(sum);
+    for (; k < len; k++) {
+        result += x[k] * y[k];
+    }
+    return result;
+}
+
+uint64_t dot_mod_p_avx2(const uint32_t *M, const uint64_t *x, size_t len, uint64_t p, uint64_t batch) {
+    // Each lane adds up to batch products before it is reduced
+    uint64_t lanes[4] = { 0, 0, 0, 0 };
+
+    size_t k = 0;
+    while (k + 4 <= len) {
+        const size_t end = k + 4 * ((len - k) / 4 < batch ? (len - k) / 4 : batch);
+
+        __m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lanes));
+        for (; k < end; k += 4) {
+            const __m256i vm = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(M + k)));
+            const __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + k));
+            sum = _mm256_add_epi64(sum, _mm256_mul_epu32(vm, vx));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sum);
+
+        for (size_t i = 0; i < 4; i++) {
+            lanes[i] %= p;
+        }
+    }
+
+    uint64_t result = (lanes[0] + lanes[1] + lanes[2] + lanes[3]) % p;
+    for (; k < len; k++) {
+        result = (result + M[k] * x[k]) % p;
+    }
+    return result;
+}
+
+#else
+
+const bool simd_avx2_compiled = false;
+
+void mul_add_avx2(uint64_t *, const uint64_t *, uint64_t, size_t) { abort(); }
+void add_avx2(uint64_t *, const uint64_t *, size_t) { abort(); }
+uint64_t dot_avx2(const uint64_t *, const uint64_t *, size_t) { abort(); }
+uint64_t dot_mod_p_avx2(const uint32_t *, const uint64_t *, size_t, uint64_t, uint64_t) { abort(); }
+
+#endif
+
+}
@@ -0,0 +1,132 @@
+/** @file
+*****************************************************************************
+
+Implementation of the AVX-512 kernels.
+
+See lwe_kernels_simd.hpp
+
+*****************************************************************************
+* @author     Samir Menon, Brennan Shacklett, and David J. Wu
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+#include <cstdlib>
+
+#include "lwe_kernels_simd.hpp"
+
+#ifdef __AVX512F__
+// The AVX-512 headers of some GCC versions trigger spurious warnings
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#endif
+
+namespace LWE {
+
+#ifdef __AVX512F__
+
+const bool simd_avx512_compiled = true;
+
+// Low 64 bits of the lane-wise products x * y (AVX-512F has no 64-bit
+// multiplication; _mm512_mullo_epi64 needs AVX-512DQ)
+static inline __m512i mullo_epi64(__m512i x, __m512i y) {
+    const __m512i lo = _mm512_mul_epu32(x, y);
+    const __m512i cross = _mm512_add_epi64(_mm512_mul_epu32(x, _mm512_srli_epi64(y, 32)),
+                                           _mm512_mul_epu32(_mm512_srli_epi64(x, 32), y));
+    return _mm512_add_epi64(lo, _mm512_slli_epi64(cross, 32));
+}
+
+void mul_add_avx512(uint64_t *acc, const uint64_t *row, uint64_t c, size_t len) {
+    // c < 2^32, so c * row[k] = c * lo(row[k]) + 2^32 * c * hi(row[k])
+    const __m512i vc = _mm512_set1_epi64(c);
+
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        const __m512i r = _mm512_loadu_si512(reinterpret_cast<const __m512i *>(row + k));
+        const __m512i lo = _mm512_mul_epu32(r, vc);
+        const __m512i hi = _mm512_mul_epu32(_mm512_srli_epi64(r, 32), vc);
+        const __m512i prod = _mm512_add_epi64(lo, _mm512_slli_epi64(hi, 32));
+
+        __m512i *a = reinterpret_cast<__m512i *>(acc + k);
+        _mm512_storeu_si512(a, _mm512_add_epi64(_mm512_loadu_si512(a), prod));
+    }
+    for (; k < len; k++) {
+        acc[k] += c * row[k];
+    }
+}
+
+void add_avx512(uint64_t *acc, const uint64_t *row, size_t len) {
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        const __m512i r = _mm512_loadu_si512(reinterpret_cast<const __m512i *>(row + k));
+        __m512i *a = reinterpret_cast<__m512i *>(acc + k);
+        _mm512_storeu_si512(a, _mm512_add_epi64(_mm512_loadu_si512(a), r));
+    }
+    for (; k < len; k++) {
+        acc[k] += row[k];
+    }
+}
+
+uint64_t dot_avx512(const uint64_t *x, const uint64_t *y, size_t len) {
+    __m512i sum = _mm512_setzero_si512();
+
+    size_t k = 0;
+    for (; k + 8 <= len; k += 8) {
+        const __m512i vx = _mm512_loadu_si512(reinterpret_cast<const __m512i *>(x + k));
+        const __m512i vy = _mm512_loadu_si512(reinterpret_cast<const __m512i *>(y + k));
+        sum = _mm512_add_epi64(sum, mullo_epi64(vx, vy));
+    }
+
+    uint64_t result = _mm512_reduce_add_epi64(sum);
+    for (; k < len; k++) {
+        result += x[k] * y[k];
+    }
+    return result;
+}
+
+uint64_t dot_mod_p_avx512(const uint32_t *M, const uint64_t *x, size_t len, uint64_t p, uint64_t batch) {
+    // Each lane adds up to batch products before it is reduced
+    uint64_t lanes[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    size_t k = 0;
+    while (k + 8 <= len) {
+        const size_t end = k + 8 * ((len - k) / 8 < batch ? (len - k) / 8 : batch);
+
+        __m512i sum = _mm512_loadu_si512(reinterpret_cast<const __m512i *>(lanes));
+        for (; k < end; k += 8) {
+            const __m512i vm = _mm512_cvtepu32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(M + k)));
+            const __m512i vx = _mm512_loadu_si512(reinterpret_cast<const __m512i *>(x + k));
+            sum = _mm512_add_epi64(sum, _mm512_mul_epu32(vm, vx));
+        }
+        _mm512_storeu_si512(reinterpret_cast<__m512i *>(lanes), sum);
+
+        for (size_t i = 0; i < 8; i++) {
+            lanes[i] %= p;
+        }
+    }
+
+    uint64_t result = 0;
+    for (size_t i = 0; i < 8; i++) {
+        result += lanes[i];
+    }
+    result %= p;
+    for (; k < len; k++) {
+        result = (result + M[k] * x[k]) % p;
+    }
+    return result;
+}
+
+#else
+
+const bool simd_avx512_compiled = false;
+
+void mul_add_avx512(uint64_t *, const uint64_t *, uint64_t, size_t) { abort(); }
+void add_avx512(uint64_t *, const uint64_t *, size_t) { abort(); }
+uint64_t dot_avx512(const uint64_t *, const uint64_t *, size_t) { abort(); }
+uint64_t dot_mod_p_avx512(const uint32_t *, const uint64_t *, size_t, uint64_t, uint64_t) { abort(); }
+
+#endif
+
+}
@@ -0,0 +1,42 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of the AVX2 and AVX-512 kernels (see lwe_kernels.hpp), on 64-bit
+ words.
+
+ The kernels are compiled in translation units of their own with the matching
+ instruction set flags, and must only be called if the CPU supports it. These
+ translation units must not include any header with inline functions that may
+ also be used elsewhere (such as the NTL headers): the linker may keep the
+ copy compiled with the extended instruction set.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef LWE_KERNELS_SIMD_HPP_
+#define LWE_KERNELS_SIMD_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace LWE {
+
+// Whether the kernels were compiled in (x86-64 only)
+extern const bool simd_avx2_compiled;
+extern const bool simd_avx512_compiled;
+
+void mul_add_avx2(uint64_t *acc, const uint64_t *row, uint64_t c, size_t len);
+void add_avx2(uint64_t *acc, const uint64_t *row, size_t len);
+uint64_t dot_avx2(const uint64_t *x, const uint64_t *y, size_t len);
+uint64_t dot_mod_p_avx2(const uint32_t *M, const uint64_t *x, size_t len, uint64_t p, uint64_t batch);
+
+void mul_add_avx512(uint64_t *acc, const uint64_t *row, uint64_t c, size_t len);
+void add_avx512(uint64_t *acc, const uint64_t *row, size_t len);
+uint64_t dot_avx512(const uint64_t *x, const uint64_t *y, size_t len);
+uint64_t dot_mod_p_avx512(const uint32_t *M, const uint64_t *x, size_t len, uint64_t p, uint64_t batch);
+
+}
+
+#endif // LWE_KERNELS_SIMD_HPP_
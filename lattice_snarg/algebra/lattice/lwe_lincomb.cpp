@@ -0,0 +1,202 @@
+/** @file
+*****************************************************************************
+
+Implementation of linear combinations of ciphertexts of the lattice-based
+vector encryption scheme.
+
+See lwe_lincomb.hpp
+
+*****************************************************************************
+* @author     Samir Menon, Brennan Shacklett, and David J. Wu
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+
+#include "lwe_lincomb.hpp"
+#include "lwe_tuning.hpp"
+
+namespace LWE {
+
+// Number of bits in a coefficient (an element of [0, p))
+static unsigned coeff_bits() {
+    return NTL::NumBits(p - 1);
+}
+
+// Estimated cost of the bucket strategy with c-bit digits, in units of
+// ciphertext additions: every nonzero coefficient is added into one bucket per
+// digit position, the buckets are combined with 2 additions each, and the
+// digit positions are combined with one scalar multiplication (of cost
+// mul_cost) each.
+static double bucket_cost(size_t num_nonzero, unsigned c, double mul_cost) {
+    const unsigned windows = (coeff_bits() + c - 1) / c;
+    return windows * (num_nonzero + 2.0 * ((1ul << c) - 1)) + (windows - 1) * mul_cost;
+}
+
+const char* lincomb_strategy_name(lincomb_strategy strategy) {
+    switch (strategy) {
+        case lincomb_strategy::automatic: return "automatic";
+        case lincomb_strategy::dense:     return "dense";
+        case lincomb_strategy::sparse:    return "sparse";
+        case lincomb_strategy::bucket:    return "bucket";
+    }
+    return "unknown";
+}
+
+lincomb_plan plan_linear_combination(const std::vector<uint64_t> &coeffs,
+                                     lincomb_strategy strategy) {
+    lincomb_plan plan;
+    plan.num_zero = 0;
+    plan.num_one = 0;
+    plan.num_other = 0;
+
+    for (size_t i = 0; i < coeffs.size(); i++) {
+        assert(coeffs[i] < p_int);
+        if (coeffs[i] == 0) {
+            plan.num_zero++;
+        } else if (coeffs[i] == 1) {
+            plan.num_one++;
+        } else {
+            plan.num_other++;
+        }
+    }
+
+    const size_t num_nonzero = plan.num_one + plan.num_other;
+    // Measured on this host by lattice_snarg_tune, if a profile is loaded
+    const double mul_cost = active_tuning_profile().lincomb_mul_cost;
+
+    // Digit size minimizing the cost of the bucket strategy
+    plan.window_bits = 1;
+    for (unsigned c = 2; c <= lincomb_max_window_bits; c++) {
+        if (bucket_cost(num_nonzero, c, mul_cost) < bucket_cost(num_nonzero, plan.window_bits, mul_cost)) {
+            plan.window_bits = c;
+        }
+    }
+
+    if (strategy != lincomb_strategy::automatic) {
+        plan.strategy = strategy;
+    } else {
+        // The sparse strategy always dominates the dense strategy
+        const double sparse_cost = plan.num_one + plan.num_other * (mul_cost + 1);
+        if (bucket_cost(num_nonzero, plan.window_bits, mul_cost) < sparse_cost) {
+            plan.strategy = lincomb_strategy::bucket;
+        } else {
+            plan.strategy = lincomb_strategy::sparse;
+        }
+    }
+
+    return plan;
+}
+
+// acc += c * v
+static void mul_add_to(vector &acc, const vector &v, const NTL::ZZ_p &c) {
+    NTL::ZZ_p t;
+    for (long k = 0; k < acc.length(); k++) {
+        NTL::mul(t, v[k], c);
+        NTL::add(acc[k], acc[k], t);
+    }
+}
+
+static void bucket_linear_combination(vector &result,
+                                      const std::vector<const vector*> &rows,
+                                      const std::vector<uint64_t> &coeffs,
+                                      unsigned c) {
+    const uint64_t digit_mask = (1ul << c) - 1;
+    const unsigned windows = (coeff_bits() + c - 1) / c;
+    const NTL::ZZ_p shift(1ul << c);
+
+    // buckets[d - 1] holds the sum of the ciphertexts with digit d
+    std::vector<vector> buckets(digit_mask);
+    std::vector<bool> used(digit_mask);
+    vector running;
+
+    // Horner's rule over the digit positions, most significant first
+    for (unsigned w = windows; w-- > 0; ) {
+        if (w + 1 < windows) {
+            NTL::mul(result, result, shift);
+        }
+
+        std::fill(used.begin(), used.end(), false);
+        for (size_t i = 0; i < coeffs.size(); i++) {
+            const uint64_t d = (coeffs[i] >> (w * c)) & digit_mask;
+            if (d == 0) {
+                continue;
+            }
+
+            if (used[d - 1]) {
+                NTL::add(buckets[d - 1], buckets[d - 1], *rows[i]);
+            } else {
+                buckets[d - 1] = *rows[i];
+                used[d - 1] = true;
+            }
+        }
+
+        // sum_d d * B_d = sum_d (B_d + B_{d+1} + ... + B_{2^c - 1})
+        bool have_running = false;
+        for (uint64_t d = digit_mask; d >= 1; d--) {
+            if (used[d - 1]) {
+                if (have_running) {
+                    NTL::add(running, running, buckets[d - 1]);
+                } else {
+                    running = buckets[d - 1];
+                    have_running = true;
+                }
+            }
+
+            if (have_running) {
+                NTL::add(result, result, running);
+            }
+        }
+    }
+}
+
+ciphertext linear_combination(const std::vector<ciphertext> &cts,
+                              const std::vector<uint64_t> &coeffs,
+                              const lincomb_plan &plan) {
+    assert(cts.size() == coeffs.size());
+    NTL::ZZ_pPush push(q_context());
+
+    ciphertext result;
+    result.ctxt.SetLength(n + pt_dim);
+
+    switch (plan.strategy) {
+        case lincomb_strategy::dense:
+            for (size_t i = 0; i < coeffs.size(); i++) {
+                mul_add_to(result.ctxt, cts[i].ctxt, NTL::ZZ_p(coeffs[i]));
+            }
+            break;
+
+        case lincomb_strategy::bucket: {
+            std::vector<const vector*> rows(cts.size());
+            for (size_t i = 0; i < cts.size(); i++) {
+                rows[i] = &cts[i].ctxt;
+            }
+            bucket_linear_combination(result.ctxt, rows, coeffs, plan.window_bits);
+            break;
+        }
+
+        case lincomb_strategy::automatic:
+        case lincomb_strategy::sparse:
+            for (size_t i = 0; i < coeffs.size(); i++) {
+                if (coeffs[i] == 0) {
+                    continue;
+                } else if (coeffs[i] == 1) {
+                    NTL::add(result.ctxt, result.ctxt, cts[i].ctxt);
+                } else {
+                    mul_add_to(result.ctxt, cts[i].ctxt, NTL::ZZ_p(coeffs[i]));
+                }
+            }
+            break;
+    }
+
+    return result;
+}
+
+ciphertext linear_combination(const std::vector<ciphertext> &cts,
+                              const std::vector<uint64_t> &coeffs,
+                              lincomb_strategy strategy) {
+    return linear_combination(cts, coeffs, plan_linear_combination(coeffs, strategy));
+}
+
+}
@@ -0,0 +1,101 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of interfaces for computing linear combinations of ciphertexts
+ of the lattice-based vector encryption scheme (see lwe.hpp).
+
+ The prover's response is a linear combination sum_i c_i * ct_i of the
+ encrypted queries, where the coefficients c_i are elements of the plaintext
+ field. R1CS witnesses are typically dominated by 0 and 1 values, and there
+ are only p possible coefficients, so a direct evaluation wastes most of its
+ scalar multiplications. This includes:
+ - the available evaluation strategies
+ - a planner that chooses a strategy from the coefficient histogram
+ - the linear combination algorithm
+
+ The bucket strategy is the multi-scalar multiplication algorithm of [Pip76]
+ (see also [BDLO12, Section 4]): the coefficients are split into digits of
+ c bits, and for each digit position, the ciphertexts are summed into one
+ bucket per digit value. The buckets are then combined with a running sum
+ (additions only), and the digit positions with one scalar multiplication
+ by 2^c each.
+
+ References:
+
+  [Pip76]:  Nicholas Pippenger. On the Evaluation of Powers and Related
+            Problems. In FOCS, 1976.
+
+  [BDLO12]: Daniel J. Bernstein, Jeroen Doumen, Tanja Lange, and Jan-Jaap
+            Oosterwijk. Faster Batch Forgery Identification. In INDOCRYPT, 2012.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef LWE_LINCOMB_HPP_
+#define LWE_LINCOMB_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lwe.hpp"
+
+namespace LWE {
+
+// Cost of a ciphertext scalar multiplication, in units of ciphertext additions
+// (default; a tuning profile may override it, see lwe_tuning.hpp)
+const double lincomb_mul_cost = 4.0;
+
+// Largest digit size (in bits) for the bucket strategy. The bucket strategy
+// keeps 2^c - 1 ciphertexts in memory.
+const unsigned lincomb_max_window_bits = 8;
+
+enum class lincomb_strategy {
+    automatic, // choose a strategy from the coefficient histogram
+    dense,     // one scalar multiplication per coefficient
+    sparse,    // skip zero coefficients, add unit coefficients
+    bucket     // bucket ciphertexts by coefficient digit
+};
+
+const char* lincomb_strategy_name(lincomb_strategy strategy);
+
+/**
+ * An evaluation plan for a linear combination of ciphertexts.
+ */
+class lincomb_plan {
+public:
+    lincomb_strategy strategy;
+    unsigned window_bits; // digit size for the bucket strategy
+
+    // Coefficient histogram
+    size_t num_zero;
+    size_t num_one;
+    size_t num_other;
+
+    lincomb_plan() = default;
+};
+
+/**
+ * Choose an evaluation strategy for the linear combination with coefficients
+ * coeffs (each in [0, p)). If strategy is not automatic, the plan uses the
+ * given strategy.
+ */
+lincomb_plan plan_linear_combination(const std::vector<uint64_t> &coeffs,
+                                     lincomb_strategy strategy = lincomb_strategy::automatic);
+
+/**
+ * Compute sum_i coeffs[i] * cts[i].
+ */
+ciphertext linear_combination(const std::vector<ciphertext> &cts,
+                              const std::vector<uint64_t> &coeffs,
+                              const lincomb_plan &plan);
+
+ciphertext linear_combination(const std::vector<ciphertext> &cts,
+                              const std::vector<uint64_t> &coeffs,
+                              lincomb_strategy strategy = lincomb_strategy::automatic);
+
+}
+
+#endif // LWE_LINCOMB_HPP_
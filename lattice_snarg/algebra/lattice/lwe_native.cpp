@@ -0,0 +1,193 @@
+/** @file
+*****************************************************************************
+
+Implementation of native-word layouts and kernels for the lattice-based
+vector encryption scheme.
+
+See lwe_native.hpp
+
+*****************************************************************************
+* @author     Samir Menon, Brennan Shacklett, and David J. Wu
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <thread>
+
+#include "lwe_kernels.hpp"
+#include "lwe_native.hpp"
+#include "lwe_tuning.hpp"
+
+namespace LWE {
+
+word to_word(const NTL::ZZ &x) {
+    if (sizeof(word) == sizeof(unsigned long)) {
+        return NTL::conv<unsigned long>(x);
+    }
+
+    unsigned char bytes[sizeof(word)];
+    NTL::BytesFromZZ(bytes, x, sizeof(word));
+
+    word w = 0;
+    for (size_t b = sizeof(word); b-- > 0; ) {
+        w = (w << 8) | bytes[b];
+    }
+    return w;
+}
+
+NTL::ZZ from_word(word w) {
+    if (sizeof(word) == sizeof(unsigned long)) {
+        return NTL::conv<NTL::ZZ>((unsigned long) w);
+    }
+
+    unsigned char bytes[sizeof(word)];
+    for (size_t b = 0; b < sizeof(word); b++) {
+        bytes[b] = (unsigned char) (w >> (8 * b));
+    }
+    return NTL::ZZFromBytes(bytes, sizeof(word));
+}
+
+processed_secret_key process_secret_key(const secret_key &sk) {
+    processed_secret_key psk;
+    psk.St.resize(pt_dim * ct_dim);
+
+    for (uint32_t i = 0; i < pt_dim; i++) {
+        for (uint32_t k = 0; k < ct_dim; k++) {
+            psk.St[i * ct_dim + k] = to_word(NTL::rep(sk.S[k][i]));
+        }
+    }
+
+    return psk;
+}
+
+void decrypt_words(const processed_secret_key &psk, const word *ct, uint64_t *pt) {
+    assert(psk.St.size() == pt_dim * ct_dim);
+    const word half_q = word(1) << (log_q - 1);
+    const kernel_table &k = kernels();
+
+    for (uint32_t i = 0; i < pt_dim; i++) {
+        const word acc = k.dot(&psk.St[i * ct_dim], ct, ct_dim) & q_mask;
+
+        // Reduce the representative in (-q/2, q/2] modulo p
+        if (acc > half_q) {
+            const uint64_t neg = (uint64_t) ((q_mask - acc + 1) % p_int);
+            pt[i] = (neg == 0) ? 0 : p_int - neg;
+        } else {
+            pt[i] = (uint64_t) (acc % p_int);
+        }
+    }
+}
+
+void decrypt(const processed_secret_key &psk, const ciphertext &ct, uint64_t *pt) {
+    assert(ct.ctxt.length() == ct_dim);
+
+    word ct_words[ct_dim];
+    for (uint32_t k = 0; k < ct_dim; k++) {
+        ct_words[k] = to_word(NTL::rep(ct.ctxt[k]));
+    }
+
+    decrypt_words(psk, ct_words, pt);
+}
+
+void mat_vec_mod_p(const uint32_t *M, const uint64_t *x, uint64_t *y, size_t rows, size_t cols) {
+    const kernel_table &k = kernels();
+    for (size_t r = 0; r < rows; r++) {
+        y[r] = k.dot_mod_p(&M[r * cols], x, cols);
+    }
+}
+
+packed_ciphertexts pack_ciphertexts(const std::vector<ciphertext> &cts, libsnark::huge_pages pages, int node) {
+    packed_ciphertexts packed(cts.size(), pages, node);
+
+    for (size_t i = 0; i < cts.size(); i++) {
+        assert(cts[i].ctxt.length() == ct_dim);
+        word *row = packed.row(i);
+        for (uint32_t k = 0; k < ct_dim; k++) {
+            row[k] = to_word(NTL::rep(cts[i].ctxt[k]));
+        }
+    }
+
+    return packed;
+}
+
+packed_ciphertexts read_packed_ciphertexts(std::istream &in, size_t num, libsnark::huge_pages pages, int node) {
+    const size_t num_bytes = (log_q + 7) / 8;
+    std::vector<unsigned char> bytes(ct_dim * num_bytes);
+
+    packed_ciphertexts packed(num, pages, node);
+    for (size_t i = 0; i < num && in; i++) {
+        in.read(reinterpret_cast<char *>(bytes.data()), bytes.size());
+
+        word *row = packed.row(i);
+        for (uint32_t k = 0; k < ct_dim; k++) {
+            word w = 0;
+            for (size_t b = num_bytes; b-- > 0; ) {
+                w = (w << 8) | bytes[k * num_bytes + b];
+            }
+            row[k] = w;
+        }
+    }
+
+    return packed;
+}
+
+// acc[begin, end) += sum_i coeffs[i] * cts[i][begin, end)
+static void accumulate_tile(const packed_ciphertexts &cts, const std::vector<uint64_t> &coeffs,
+                            word *acc, size_t begin, size_t end) {
+    const kernel_table &k = kernels();
+    for (size_t i = 0; i < coeffs.size(); i++) {
+        assert(coeffs[i] < p_int);
+        if (coeffs[i] == 0) {
+            continue;
+        } else if (coeffs[i] == 1) {
+            k.add(acc + begin, cts.row(i) + begin, end - begin);
+        } else {
+            k.mul_add(acc + begin, cts.row(i) + begin, coeffs[i], end - begin);
+        }
+    }
+}
+
+ciphertext linear_combination(const packed_ciphertexts &cts, const std::vector<uint64_t> &coeffs) {
+    const tuning_profile &profile = active_tuning_profile();
+    return linear_combination(cts, coeffs, profile.lincomb_tile_words, profile.lincomb_threads);
+}
+
+ciphertext linear_combination(const packed_ciphertexts &cts, const std::vector<uint64_t> &coeffs,
+                              size_t tile_words, size_t num_threads) {
+    assert(cts.size() == coeffs.size());
+
+    const size_t tile = (tile_words == 0 || tile_words > ct_dim) ? ct_dim : tile_words;
+    const size_t num_tiles = (ct_dim + tile - 1) / tile;
+
+    // The threads take the next tile until there is none left. The tiles are
+    // disjoint, so the threads write to disjoint parts of acc.
+    std::vector<word> acc(ct_dim, 0);
+    std::atomic<size_t> next_tile(0);
+    auto accumulate_tiles = [&]() {
+        for (size_t t = next_tile++; t < num_tiles; t = next_tile++) {
+            accumulate_tile(cts, coeffs, acc.data(), t * tile, std::min<size_t>(ct_dim, (t + 1) * tile));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(num_threads, num_tiles); i++) {
+        threads.emplace_back(accumulate_tiles);
+    }
+    accumulate_tiles();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    NTL::ZZ_pPush push(q_context());
+    ciphertext result;
+    result.ctxt.SetLength(ct_dim);
+    for (uint32_t j = 0; j < ct_dim; j++) {
+        NTL::conv(result.ctxt[j], from_word(acc[j] & q_mask));
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,152 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of native-word layouts and kernels for the lattice-based vector
+ encryption scheme (see lwe.hpp).
+
+ The ciphertext modulus q = 2^log_q is a power of two, so arithmetic modulo q
+ can be carried out in a native unsigned word of at least log_q bits with
+ wrap-around, and reduced by masking at the end. The plaintext modulus p is
+ below 2^32, so plaintext elements fit in 32-bit words and products of two
+ plaintext elements fit in 64-bit words.
+
+ The kernels run on the backend selected at run time (see lwe_kernels.hpp).
+
+ This includes:
+ - native word type for elements of Z_q
+ - class for a secret key preprocessed for decryption
+ - preprocessing and decryption algorithms
+ - dot products modulo p with lazy reduction
+ - class for ciphertexts packed in contiguous native words (with explicit page
+   size and NUMA placement, see numa_memory.hpp), and linear combinations
+   over them
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef LWE_NATIVE_HPP_
+#define LWE_NATIVE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#include <lattice_snarg/common/numa_memory.hpp>
+
+#include "lwe.hpp"
+#include "lwe_params.hpp"
+
+namespace LWE {
+
+// Native word holding an element of Z_q
+using word = std::conditional<(log_q <= 64), uint64_t, unsigned __int128>::type;
+
+const word q_mask = (log_q == 8*sizeof(word)) ? ~word(0) : (word(1) << log_q) - 1;
+
+// Dimension of a ciphertext
+const uint32_t ct_dim = n + pt_dim;
+
+// Size of a serialized ciphertext (see operator<< in lwe.hpp), in bytes
+const size_t ct_bytes = ct_dim * ((log_q + 7) / 8);
+
+// Conversions between elements of [0, q) and native words
+word to_word(const NTL::ZZ &x);
+NTL::ZZ from_word(word w);
+
+static_assert(p_int < (1ul << 32), "plaintext elements must fit in 32-bit words");
+
+// Number of products of two elements of Z_p that can be added to a value
+// below p without overflowing a 64-bit word
+const uint64_t lazy_reduction_batch = (UINT64_MAX - p_int) / ((p_int - 1) * (p_int - 1));
+
+/**
+ * A secret key preprocessed for decryption: S^T (pt_dim x ct_dim) in
+ * contiguous row-major native words.
+ */
+class processed_secret_key {
+public:
+    std::vector<word> St;
+
+    processed_secret_key() = default;
+};
+
+processed_secret_key process_secret_key(const secret_key &sk);
+
+/**
+ * Decrypt ct into pt[0..pt_dim) (elements of [0, p)). Does not allocate.
+ * ct must have ct_dim components (callers decrypting untrusted ciphertexts
+ * check this first).
+ */
+void decrypt(const processed_secret_key &psk, const ciphertext &ct, uint64_t *pt);
+
+/**
+ * Decrypt a ciphertext given as ct_dim native words.
+ */
+void decrypt_words(const processed_secret_key &psk, const word *ct, uint64_t *pt);
+
+/**
+ * Compute y = M * x mod p, where M is a rows x cols row-major matrix of
+ * elements of [0, p), and x has cols elements of [0, p).
+ */
+void mat_vec_mod_p(const uint32_t *M, const uint64_t *x, uint64_t *y, size_t rows, size_t cols);
+
+/**
+ * A sequence of ciphertexts, each stored as ct_dim contiguous native words, in
+ * one mapped buffer. Unlike a std::vector<ciphertext> (one heap allocation per
+ * element of Z_q), a linear combination over packed ciphertexts streams through
+ * contiguous memory, and the buffer can be backed by huge pages and placed on
+ * a given NUMA node.
+ */
+class packed_ciphertexts {
+public:
+    size_t num;
+    libsnark::mapped_buffer buffer;
+
+    packed_ciphertexts() : num(0) {};
+    packed_ciphertexts(size_t num, libsnark::huge_pages pages, int node) :
+        num(num),
+        buffer(num * ct_dim * sizeof(word), pages, node)
+    {};
+
+    size_t size() const { return num; }
+    const word* row(size_t i) const { return static_cast<const word*>(buffer.data()) + i * ct_dim; }
+    word* row(size_t i) { return static_cast<word*>(buffer.data()) + i * ct_dim; }
+};
+
+/**
+ * Pack cts into a buffer with the given page size and placement. The packing
+ * thread writes (and so places) every page.
+ */
+packed_ciphertexts pack_ciphertexts(const std::vector<ciphertext> &cts,
+                                    libsnark::huge_pages pages = libsnark::huge_pages::transparent,
+                                    int node = libsnark::numa_node_any);
+
+/**
+ * Read num ciphertexts in the binary format of operator<< (see lwe.hpp)
+ * directly into a packed buffer. Sets the failbit of in on a short read.
+ */
+packed_ciphertexts read_packed_ciphertexts(std::istream &in, size_t num,
+                                           libsnark::huge_pages pages = libsnark::huge_pages::transparent,
+                                           int node = libsnark::numa_node_any);
+
+/**
+ * Compute sum_i coeffs[i] * cts[i] over packed ciphertexts, with coefficients
+ * in [0, p). Zero coefficients are skipped.
+ *
+ * The ciphertext components are split into tiles of tile_words words (0 for a
+ * single tile), and the tiles are accumulated by num_threads threads. The
+ * first overload uses the settings of the active tuning profile (see
+ * lwe_tuning.hpp).
+ */
+ciphertext linear_combination(const packed_ciphertexts &cts, const std::vector<uint64_t> &coeffs);
+
+ciphertext linear_combination(const packed_ciphertexts &cts, const std::vector<uint64_t> &coeffs,
+                              size_t tile_words, size_t num_threads);
+
+}
+
+#endif // LWE_NATIVE_HPP_
@@ -2,14 +2,25 @@
  *****************************************************************************
 
  Sample parameters for the lattice-based vector encryption scheme for the
- lattice-based R1CS ppSNARG. The LWE parameters are chosen to provide 80-bits
- of security, and correctness error 2^{-40} for verifying QAPs with degree up
- to 10000 (over a finite field of size ~10000). Parameter selection based on
- the security analysis in [LP10].
+ lattice-based R1CS ppSNARG. Parameter selection based on the security analysis
+ in [LP10]. Two parameter sets are provided, selected at build time with the
+ LWE_PARAMS CMake option:
 
- The plaintext dimension is chosen based on the number of queries needed to
- acheive soundness error 2^{-40} for the QAP-based linear PCP for verifying
- R1CS systems with up to 10000 constraints (and a field of size ~10000).
+ - P16 (default): plaintext field of size p = 65537 = 2^16 + 1. The LWE
+   parameters are chosen to provide 80-bits of security, and correctness error
+   2^{-40} for verifying QAPs with degree up to 10000. The plaintext dimension
+   is chosen based on the number of queries needed to acheive soundness error
+   2^{-40} for the QAP-based linear PCP for R1CS systems with up to 10000
+   constraints.
+
+ - P31: plaintext field of size p = 2013265921 = 15 * 2^27 + 1. The field has
+   2-adicity 27, so the QAP evaluation domain is no longer the limiting factor,
+   and each query of the linear PCP has soundness error ~2^{-11} for R1CS
+   systems with up to 2^20 constraints, so 4 queries suffice for soundness
+   error 2^{-40}. The larger plaintext space requires a ciphertext modulus of
+   2^90 for correctness error 2^{-40}; the lattice dimension is scaled with
+   log(q/stddev) to keep the root-Hermite factor (and thus the security level)
+   of the P16 parameters.
 
  References:
 
@@ -25,11 +36,35 @@
 #define LWE_PARAM_HPP_
 
 #include <math.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <NTL/ZZ.h>
 
 namespace LWE {
 
+#if defined(LWE_PARAMS_P31)
+
+// Lattice dimension (parameters chosen to ensure 80-bits of security)
+const uint32_t n = 2300;
+
+// Noise distribution standard deviation
+const double stddev = 6.0;
+
+// 4 queries (~ 2^-40 soundness error for circuits of size < 2^20)
+const uint32_t l = 4;
+const uint32_t pt_dim = l*4;
+
+// Plaintext modulus
+const uint64_t p_int = 2013265921;
+
+// Ciphertext modulus is 2^log_q
+const uint32_t log_q = 90;
+
+// Largest QAP degree covered by the soundness and correctness analysis
+const size_t max_qap_degree = 1ul << 20;
+
+#else // LWE_PARAMS_P16
+
 // Lattice dimension (parameters chosen to ensure 80-bits of security)
 const uint32_t n = 1455;
 
@@ -42,10 +77,19 @@ const uint32_t pt_dim = l*4;
 
 // Plaintext modulus
 const uint64_t p_int = 65537;
+
+// Ciphertext modulus is 2^log_q
+const uint32_t log_q = 58;
+
+// Largest QAP degree covered by the soundness and correctness analysis
+const size_t max_qap_degree = 10000;
+
+#endif
+
 const NTL::ZZ p(p_int);
 
 // Ciphertext modulus
-const NTL::ZZ q(1ul << 58);
+const NTL::ZZ q(NTL::power2_ZZ(log_q));
 }
 
 #endif // LWE_PARAM_HPP_
@@ -0,0 +1,106 @@
+/** @file
+*****************************************************************************
+
+Implementation of the pool of precomputed encryptions of zero.
+
+See lwe_pool.hpp
+
+*****************************************************************************
+* @author     Samir Menon, Brennan Shacklett, and David J. Wu
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+#include <stdexcept>
+
+#include "lwe_pool.hpp"
+
+namespace LWE {
+
+encryption_pool::encryption_pool(const std::shared_ptr<const secret_key> &sk, size_t capacity, size_t num_threads) :
+    sk_(sk), capacity_(capacity), in_progress_(0), misses_(0), stop_(false)
+{
+    if (num_threads > 1 && !threads_supported()) {
+        throw std::runtime_error("encryption_pool: NTL was built without NTL_THREADS; use at most one thread");
+    }
+
+    for (size_t i = 0; i < num_threads; i++) {
+        threads_.emplace_back(&encryption_pool::fill, this);
+    }
+}
+
+encryption_pool::~encryption_pool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    not_full_.notify_all();
+
+    for (std::thread &thread : threads_) {
+        thread.join();
+    }
+}
+
+bool encryption_pool::threads_supported() {
+#if defined(NTL_THREADS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t encryption_pool::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ciphertexts_.size();
+}
+
+size_t encryption_pool::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+void encryption_pool::fill() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        not_full_.wait(lock, [this] { return stop_ || ciphertexts_.size() + in_progress_ < capacity_; });
+        if (stop_) {
+            return;
+        }
+
+        in_progress_++;
+        lock.unlock();
+        ciphertext zero = encrypt_zero(*sk_);
+        lock.lock();
+        in_progress_--;
+
+        ciphertexts_.emplace_back(std::move(zero));
+        if (ciphertexts_.size() == capacity_) {
+            full_.notify_all();
+        }
+    }
+}
+
+ciphertext encryption_pool::take() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ciphertexts_.empty()) {
+            ciphertext zero = std::move(ciphertexts_.front());
+            ciphertexts_.pop_front();
+            not_full_.notify_one();
+            return zero;
+        }
+        misses_++;
+    }
+
+    return encrypt_zero(*sk_);
+}
+
+void encryption_pool::wait_full() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    full_.wait(lock, [this] { return ciphertexts_.size() >= capacity_ || threads_.empty(); });
+}
+
+ciphertext encrypt(encryption_pool &pool, const plaintext &pt) {
+    return encrypt(pool.take(), pt);
+}
+
+}
@@ -0,0 +1,105 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of a pool of precomputed encryptions of zero for the lattice-based
+ vector encryption scheme (see lwe.hpp).
+
+ Almost all the work of an encryption (sampling the randomness, and computing
+ A*r plus noise) does not depend on the plaintext. An encryption pool runs this
+ part on background threads, and keeps up to a fixed number of fresh
+ encryptions of zero. Encrypting a plaintext with the pool takes one of them
+ and adds the plaintext, in one pass over pt_dim elements of Z_q. If the pool
+ is empty, the encryption of zero is computed on the calling thread instead.
+
+ Every encryption of zero is used at most once: reusing the randomness of an
+ encryption leaks the difference of the plaintexts.
+
+ Several background threads need an NTL built with NTL_THREADS (see
+ threads_supported below).
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef LWE_POOL_HPP_
+#define LWE_POOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "lwe.hpp"
+
+namespace LWE {
+
+class encryption_pool {
+public:
+    /**
+     * Start num_threads background threads that keep up to capacity
+     * encryptions of zero under sk. Throws std::runtime_error if
+     * num_threads > 1 and threads_supported() is false.
+     */
+    encryption_pool(const std::shared_ptr<const secret_key> &sk, size_t capacity, size_t num_threads = 1);
+
+    // Stops and joins the background threads
+    ~encryption_pool();
+
+    encryption_pool(const encryption_pool &other) = delete;
+    encryption_pool& operator=(const encryption_pool &other) = delete;
+
+    /**
+     * Whether NTL was built with NTL_THREADS, i.e. whether several threads
+     * can encrypt at the same time.
+     */
+    static bool threads_supported();
+
+    const std::shared_ptr<const secret_key>& key() const { return sk_; }
+    size_t capacity() const { return capacity_; }
+
+    // Number of encryptions of zero ready to be taken
+    size_t size() const;
+
+    // Number of times take() found the pool empty
+    size_t misses() const;
+
+    /**
+     * Remove an encryption of zero from the pool (or compute one, if the pool
+     * is empty). Safe to call from several threads.
+     */
+    ciphertext take();
+
+    /**
+     * Block until the pool is full (e.g. before a latency-sensitive phase).
+     */
+    void wait_full() const;
+
+private:
+    void fill();
+
+    const std::shared_ptr<const secret_key> sk_;
+    const size_t capacity_;
+
+    mutable std::mutex mutex_;
+    mutable std::condition_variable not_full_;
+    mutable std::condition_variable full_;
+    std::deque<ciphertext> ciphertexts_;
+    size_t in_progress_;
+    size_t misses_;
+    bool stop_;
+
+    std::vector<std::thread> threads_;
+};
+
+/**
+ * Encrypt pt under the key of the pool.
+ */
+ciphertext encrypt(encryption_pool &pool, const plaintext &pt);
+
+}
+
+#endif // LWE_POOL_HPP_
@@ -0,0 +1,424 @@
+/** @file
+*****************************************************************************
+
+Implementation of tuning profiles: reading, writing, loading at startup, and
+the kernel benchmarks.
+
+See lwe_tuning.hpp
+
+*****************************************************************************
+* @author     Samir Menon, Brennan Shacklett, and David J. Wu
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "lwe_lincomb.hpp"
+#include "lwe_pool.hpp"
+#include "lwe_tuning.hpp"
+
+namespace LWE {
+
+tuning_profile::tuning_profile() :
+    has_backend(false),
+    kernel_backend(backend::native),
+    lincomb_tile_words(0),
+    lincomb_threads(1),
+    lincomb_mul_cost(LWE::lincomb_mul_cost),
+    encryption_threads(1),
+    encryption_batch(16)
+{}
+
+/****************************** Reading and writing **************************/
+
+static std::string trim(const std::string &s) {
+    const size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    return s.substr(begin, s.find_last_not_of(" \t\r") - begin + 1);
+}
+
+static bool parse_size(const std::string &value, size_t &result) {
+    char *end = nullptr;
+    const unsigned long long v = strtoull(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0') {
+        return false;
+    }
+    result = v;
+    return true;
+}
+
+bool read_tuning_profile(std::istream &in, tuning_profile &profile, std::string &error) {
+    const backend all[] = { backend::ntl, backend::native, backend::avx2, backend::avx512 };
+    const std::string params[] = { "lwe_n", "ct_dim", "p", "log_q" };
+    const size_t expected_params[] = { n, ct_dim, p_int, log_q };
+
+    tuning_profile result;
+    unsigned params_found = 0; // bit i: params[i]
+
+    std::string line;
+    for (size_t line_number = 1; std::getline(in, line); line_number++) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            error = "line " + std::to_string(line_number) + ": expected key = value";
+            return false;
+        }
+        const std::string key = trim(line.substr(0, eq));
+        const std::string value = trim(line.substr(eq + 1));
+
+        const size_t param = std::find(params, params + 4, key) - params;
+        bool ok = true;
+        if (param < 4) {
+            if (params_found & (1u << param)) {
+                error = "line " + std::to_string(line_number) + ": duplicate key " + key;
+                return false;
+            }
+            params_found |= 1u << param;
+
+            size_t v = 0;
+            ok = parse_size(value, v);
+            if (ok && v != expected_params[param]) {
+                error = "tuned for " + key + " = " + value + ", but this build has " + key + " = " +
+                        std::to_string(expected_params[param]);
+                return false;
+            }
+        } else if (key == "cpu") {
+            result.cpu = value;
+        } else if (key == "backend") {
+            result.has_backend = false;
+            ok = (value == "auto");
+            for (backend b : all) {
+                if (value == backend_name(b)) {
+                    result.has_backend = true;
+                    result.kernel_backend = b;
+                    ok = true;
+                }
+            }
+        } else if (key == "lincomb_tile_words") {
+            ok = parse_size(value, result.lincomb_tile_words);
+        } else if (key == "lincomb_threads") {
+            ok = parse_size(value, result.lincomb_threads) && result.lincomb_threads >= 1;
+        } else if (key == "lincomb_mul_cost") {
+            char *end = nullptr;
+            result.lincomb_mul_cost = strtod(value.c_str(), &end);
+            ok = !value.empty() && *end == '\0' && result.lincomb_mul_cost > 0;
+        } else if (key == "encryption_threads") {
+            ok = parse_size(value, result.encryption_threads) && result.encryption_threads >= 1;
+        } else if (key == "encryption_batch") {
+            ok = parse_size(value, result.encryption_batch) && result.encryption_batch >= 1;
+        } else {
+            error = "line " + std::to_string(line_number) + ": unknown key " + key;
+            return false;
+        }
+
+        if (!ok) {
+            error = "line " + std::to_string(line_number) + ": invalid value for " + key;
+            return false;
+        }
+    }
+
+    if (params_found != 0xf) {
+        error = "missing LWE parameters (lwe_n, ct_dim, p, log_q)";
+        return false;
+    }
+
+    profile = result;
+    return true;
+}
+
+// The CPU model, from /proc/cpuinfo
+static std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0 && line.find(':') != std::string::npos) {
+            return trim(line.substr(line.find(':') + 1));
+        }
+    }
+    return "unknown";
+}
+
+void write_tuning_profile(std::ostream &out, const tuning_profile &profile) {
+    out << "# lattice_snarg tuning profile (see lwe_tuning.hpp)" << std::endl;
+    if (!profile.cpu.empty()) {
+        out << "cpu = " << profile.cpu << std::endl;
+    }
+    out << "lwe_n = " << n << std::endl;
+    out << "ct_dim = " << ct_dim << std::endl;
+    out << "p = " << p_int << std::endl;
+    out << "log_q = " << log_q << std::endl;
+    out << "backend = " << (profile.has_backend ? backend_name(profile.kernel_backend) : "auto") << std::endl;
+    out << "lincomb_tile_words = " << profile.lincomb_tile_words << std::endl;
+    out << "lincomb_threads = " << profile.lincomb_threads << std::endl;
+    out << "lincomb_mul_cost = " << profile.lincomb_mul_cost << std::endl;
+    out << "encryption_threads = " << profile.encryption_threads << std::endl;
+    out << "encryption_batch = " << profile.encryption_batch << std::endl;
+}
+
+static tuning_profile load_active_tuning_profile() {
+    const char *path = getenv("LATTICE_SNARG_PROFILE");
+    if (path == nullptr || *path == '\0') {
+        return tuning_profile();
+    }
+
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "LATTICE_SNARG_PROFILE: cannot open %s; using the default settings\n", path);
+        return tuning_profile();
+    }
+
+    tuning_profile profile;
+    std::string error;
+    if (!read_tuning_profile(in, profile, error)) {
+        fprintf(stderr, "LATTICE_SNARG_PROFILE: %s: %s; using the default settings\n", path, error.c_str());
+        return tuning_profile();
+    }
+    if (!profile.cpu.empty() && profile.cpu != cpu_model()) {
+        fprintf(stderr, "LATTICE_SNARG_PROFILE: %s: tuned on %s, but this host has %s; using the default settings\n",
+                path, profile.cpu.c_str(), cpu_model().c_str());
+        return tuning_profile();
+    }
+    return profile;
+}
+
+const tuning_profile& active_tuning_profile() {
+    static const tuning_profile profile = load_active_tuning_profile();
+    return profile;
+}
+
+/********************************* Benchmarks ********************************/
+
+// Average running time of f in seconds, over at least min_time seconds
+template<typename F>
+static double time_per_call(F f, double min_time) {
+    typedef std::chrono::steady_clock clock;
+
+    f(); // warm up
+
+    const clock::time_point start = clock::now();
+    size_t calls = 0;
+    double elapsed = 0;
+    do {
+        f();
+        calls++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < min_time);
+
+    return elapsed / calls;
+}
+
+static word random_word(std::mt19937_64 &rng) {
+    word w = 0;
+    for (size_t b = 0; b < sizeof(word); b += 8) {
+        w = (w << 32 << 32) | rng();
+    }
+    return w & q_mask;
+}
+
+// Ciphertexts with uniformly random components (read from random bytes)
+static std::vector<ciphertext> random_ciphertexts(size_t num, std::mt19937_64 &rng) {
+    const size_t num_bytes = (log_q + 7) / 8;
+    std::string bytes(num * ct_dim * num_bytes, '\0');
+    for (char &c : bytes) {
+        c = (char) rng();
+    }
+
+    std::istringstream in(bytes);
+    std::vector<ciphertext> cts(num);
+    for (ciphertext &ct : cts) {
+        in >> ct;
+    }
+    return cts;
+}
+
+static std::vector<size_t> thread_counts(size_t max_threads) {
+    std::vector<size_t> counts;
+    for (size_t t = 1; t < max_threads; t *= 2) {
+        counts.push_back(t);
+        if (t > max_threads / 2) {
+            break; // 2 * t >= max_threads, and may overflow
+        }
+    }
+    counts.push_back(max_threads);
+    return counts;
+}
+
+tuning_profile tune_profile(const tuning_options &options, std::ostream &log) {
+    const size_t max_threads = (options.max_threads != 0) ? options.max_threads :
+                               std::max<unsigned>(1, std::thread::hardware_concurrency());
+    std::mt19937_64 rng(1);
+    tuning_profile profile;
+    profile.cpu = cpu_model();
+
+    log << "Tuning for n = " << n << ", ct_dim = " << ct_dim << ", p = " << p_int << ", log_q = " << log_q
+        << ", up to " << max_threads << " threads" << std::endl;
+
+    // Accumulation: the prover's linear combination over packed ciphertexts,
+    // with coefficients distributed like a typical R1CS witness (zeros, ones,
+    // and arbitrary field elements)
+    packed_ciphertexts rows(options.num_rows, libsnark::huge_pages::transparent, libsnark::numa_node_any);
+    for (size_t i = 0; i < options.num_rows; i++) {
+        for (uint32_t k = 0; k < ct_dim; k++) {
+            rows.row(i)[k] = random_word(rng);
+        }
+    }
+    std::vector<uint64_t> coeffs(options.num_rows);
+    for (size_t i = 0; i < options.num_rows; i++) {
+        coeffs[i] = (i % 3 == 0) ? 0 : (i % 3 == 1) ? 1 : rng() % p_int;
+    }
+
+    // Decryption: the verifier's inner products with the processed secret key
+    processed_secret_key psk;
+    psk.St.resize(pt_dim * ct_dim);
+    for (word &w : psk.St) {
+        w = random_word(rng);
+    }
+    std::vector<word> ct(ct_dim);
+    for (word &w : ct) {
+        w = random_word(rng);
+    }
+    uint64_t pt[pt_dim];
+
+    // Backend: the fastest on accumulation and decryption, each relative to
+    // the best backend on that kernel
+    const backend initial_backend = active_backend();
+    const backend candidates[] = { backend::native, backend::avx2, backend::avx512 };
+    std::vector<backend> backends;
+    std::vector<double> accumulate_times, decrypt_times;
+    for (backend b : candidates) {
+        if (!backend_available(b)) {
+            continue;
+        }
+        set_backend(b);
+        backends.push_back(b);
+        accumulate_times.push_back(time_per_call([&] { linear_combination(rows, coeffs, 0, 1); }, options.min_time));
+        decrypt_times.push_back(time_per_call([&] { decrypt_words(psk, ct.data(), pt); }, options.min_time));
+        log << "  backend " << backend_name(b) << ": accumulation " << accumulate_times.back() * 1e3 << " ms, "
+            << "decryption " << decrypt_times.back() * 1e6 << " us" << std::endl;
+    }
+
+    const double best_accumulate = *std::min_element(accumulate_times.begin(), accumulate_times.end());
+    const double best_decrypt = *std::min_element(decrypt_times.begin(), decrypt_times.end());
+    double best_score = 0;
+    for (size_t i = 0; i < backends.size(); i++) {
+        const double score = accumulate_times[i] / best_accumulate + decrypt_times[i] / best_decrypt;
+        if (i == 0 || score < best_score) {
+            best_score = score;
+            profile.has_backend = true;
+            profile.kernel_backend = backends[i];
+        }
+    }
+    set_backend(profile.kernel_backend);
+    log << "Backend: " << backend_name(profile.kernel_backend) << std::endl;
+
+    // Tiles and threads of the accumulation, with the chosen backend
+    const size_t tile_sizes[] = { 0, 64, 128, 256, 512 };
+    double best_time = 0;
+    for (size_t threads : thread_counts(max_threads)) {
+        for (size_t tile : tile_sizes) {
+            const size_t num_tiles = (tile == 0) ? 1 : (ct_dim + tile - 1) / tile;
+            if (num_tiles < threads) {
+                continue;
+            }
+
+            const double time = time_per_call([&] { linear_combination(rows, coeffs, tile, threads); }, options.min_time);
+            log << "  accumulation, " << threads << " threads, tile " << tile << ": " << time * 1e3 << " ms" << std::endl;
+            if (best_time == 0 || time < best_time) {
+                best_time = time;
+                profile.lincomb_tile_words = tile;
+                profile.lincomb_threads = threads;
+            }
+        }
+    }
+    log << "Accumulation: " << profile.lincomb_threads << " threads, tile " << profile.lincomb_tile_words << std::endl;
+
+    // Relative cost of scalar multiplications in linear combinations of
+    // (non-packed) ciphertexts: the sparse strategy does one addition per unit
+    // coefficient, and one multiplication and addition per other coefficient
+    {
+        const std::vector<ciphertext> cts = random_ciphertexts(64, rng);
+        const std::vector<uint64_t> ones(cts.size(), 1);
+        std::vector<uint64_t> others(cts.size());
+        for (uint64_t &c : others) {
+            c = 2 + rng() % (p_int - 2);
+        }
+
+        const double add_time = time_per_call([&] { linear_combination(cts, ones, lincomb_strategy::sparse); }, options.min_time);
+        const double mul_add_time = time_per_call([&] { linear_combination(cts, others, lincomb_strategy::sparse); }, options.min_time);
+        profile.lincomb_mul_cost = std::max(1.0, mul_add_time / add_time - 1);
+        log << "Scalar multiplication cost: " << profile.lincomb_mul_cost << " additions" << std::endl;
+    }
+
+    // Encryption: inline, or with a pool of encryptions of zero filled by
+    // background threads (as in the generator). The key only needs a random A.
+    {
+        std::shared_ptr<secret_key> sk = std::make_shared<secret_key>();
+        {
+            NTL::ZZ_pPush push(q_context());
+            for (long i = 0; i < sk->A.NumRows(); i++) {
+                for (long j = 0; j < sk->A.NumCols(); j++) {
+                    NTL::conv(sk->A[i][j], from_word(random_word(rng)));
+                }
+            }
+        }
+        const std::shared_ptr<const secret_key> key = sk;
+
+        NTL::ZZ_pPush push(p_context());
+        const plaintext zero_pt(NTL::INIT_SIZE, pt_dim);
+
+        double best_encrypt = time_per_call([&] { encrypt(*key, zero_pt); }, options.min_time);
+        log << "  encryption, inline: " << best_encrypt * 1e3 << " ms" << std::endl;
+        profile.encryption_threads = 1;
+
+        if (!encryption_pool::threads_supported()) {
+            log << "  encryption pools: NTL was built without NTL_THREADS, skipped" << std::endl;
+        }
+        for (size_t threads : thread_counts(max_threads)) {
+            if (threads == 1 || !encryption_pool::threads_supported()) {
+                continue;
+            }
+
+            const size_t batches[] = { threads, 4 * threads };
+            for (size_t batch : batches) {
+                const size_t num = options.encryptions_per_thread * threads;
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                {
+                    encryption_pool pool(key, batch, threads);
+                    for (size_t i = 0; i < num; i++) {
+                        encrypt(pool, zero_pt);
+                    }
+                }
+                const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / num;
+
+                log << "  encryption, " << threads << " threads, batch " << batch << ": " << time * 1e3 << " ms" << std::endl;
+                if (time < best_encrypt) {
+                    best_encrypt = time;
+                    profile.encryption_threads = threads;
+                    profile.encryption_batch = batch;
+                }
+            }
+        }
+        log << "Encryption: " << profile.encryption_threads << " threads, batch " << profile.encryption_batch << std::endl;
+    }
+
+    set_backend(initial_backend);
+
+    return profile;
+}
+
+}
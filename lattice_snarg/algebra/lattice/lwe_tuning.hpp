@@ -0,0 +1,117 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of tuning profiles for the kernels of the lattice-based vector
+ encryption scheme.
+
+ The fastest kernel settings depend on the host (vector units, cache sizes,
+ number of cores and memory channels). A tuning profile records them:
+ - the arithmetic backend (see lwe_kernels.hpp);
+ - the tile size and number of threads of linear combinations over packed
+   ciphertexts (the prover, see lwe_native.hpp);
+ - the relative cost of a ciphertext scalar multiplication, from which the
+   planner chooses the bucket width of linear combinations (see
+   lwe_lincomb.hpp);
+ - the number of threads and the batch size (number of encryptions of zero
+   computed ahead) used by the generator to encrypt the queries (see
+   lwe_pool.hpp).
+
+ The lattice_snarg_tune tool benchmarks the kernels on the current host (with
+ tune_profile below) and saves the best settings to a profile file. The
+ generator, prover and verifier load the profile named by the environment
+ variable LATTICE_SNARG_PROFILE when they first use a kernel; without it (or if
+ the profile was tuned for other LWE parameters, or on another CPU model), the
+ defaults below apply.
+ The environment variable LATTICE_SNARG_BACKEND takes precedence over the
+ backend of the profile.
+
+ The profile file is a text file with one "key = value" line per setting;
+ lines starting with # are comments.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef LWE_TUNING_HPP_
+#define LWE_TUNING_HPP_
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include "lwe_kernels.hpp"
+
+namespace LWE {
+
+class tuning_profile {
+public:
+    // CPU model of the host the profile was tuned on (empty: any)
+    std::string cpu;
+
+    // Whether the profile selects the backend (otherwise, the fastest
+    // available one by CPUID)
+    bool has_backend;
+    backend kernel_backend;
+
+    // Linear combinations over packed ciphertexts (0: one tile)
+    size_t lincomb_tile_words;
+    size_t lincomb_threads;
+
+    // Cost of a ciphertext scalar multiplication, in ciphertext additions
+    double lincomb_mul_cost;
+
+    // Encryption of the queries by the generator (1 thread: no pool)
+    size_t encryption_threads;
+    size_t encryption_batch;
+
+    // The defaults
+    tuning_profile();
+};
+
+/**
+ * Read a profile. Returns false (and sets error) on a malformed line, an
+ * unknown backend, or a profile tuned for other LWE parameters. Each of the
+ * LWE parameters (lwe_n, ct_dim, p, log_q) must appear exactly once.
+ */
+bool read_tuning_profile(std::istream &in, tuning_profile &profile, std::string &error);
+
+/**
+ * Write a profile, with the LWE parameters it was tuned for.
+ */
+void write_tuning_profile(std::ostream &out, const tuning_profile &profile);
+
+/**
+ * The profile read from the file named by LATTICE_SNARG_PROFILE (read once,
+ * on first use), or the defaults.
+ */
+const tuning_profile& active_tuning_profile();
+
+class tuning_options {
+public:
+    // Largest number of threads to try (0: all hardware threads)
+    size_t max_threads;
+
+    // Number of packed ciphertexts in the accumulation benchmark
+    size_t num_rows;
+
+    // Number of encryptions per thread in the encryption benchmark
+    size_t encryptions_per_thread;
+
+    // Minimum running time of each measurement, in seconds
+    double min_time;
+
+    tuning_options() : max_threads(0), num_rows(4096), encryptions_per_thread(4), min_time(0.2) {}
+};
+
+/**
+ * Benchmark the encryption, accumulation and decryption kernels with the
+ * compiled LWE parameters, and return the fastest settings. Progress and
+ * measurements are written to log. Changes the active backend while it runs
+ * (and restores it).
+ */
+tuning_profile tune_profile(const tuning_options &options, std::ostream &log);
+
+}
+
+#endif // LWE_TUNING_HPP_
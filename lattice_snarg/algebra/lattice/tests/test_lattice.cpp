@@ -11,8 +11,15 @@ vector encryption scheme.
 
 #include <libff/common/profiling.hpp>
 #include <lattice_snarg/algebra/lattice/lwe.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_kernels.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_lincomb.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_native.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_pool.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_tuning.hpp>
 #include <lattice_snarg/algebra/fields/ntlfp.hpp>
 #include <cinttypes>
+#include <memory>
+#include <sstream>
 
 using namespace std;
 using namespace libsnark;
@@ -70,6 +77,14 @@ int main() {
         success = check_relation(d2[i], out2[i], "Decryption 2", i) && success;
     }
 
+    // Decryption with a processed secret key
+    LWE::processed_secret_key LWE_psk = LWE::process_secret_key(LWE_sk);
+    uint64_t outnative[LWE::pt_dim];
+    LWE::decrypt(LWE_psk, ct1, outnative);
+    for (uint32_t i = 0; i < LWE::pt_dim; i++) {
+        success = check_relation(d1[i], Fr(outnative[i]), "Native Decryption", i) && success;
+    }
+
     NTL::ZZ_p::init(NTL::ZZ(LWE::q));
     LWE::plaintext outadd = LWE::decrypt(LWE_sk, ct1 + ct2);
     for (uint32_t i = 0; i < LWE::pt_dim; i++) {
@@ -88,6 +103,152 @@ int main() {
         success = check_relation(c1p*d1[i]+c2p*d2[i], out[i], "Linear Relation", i) && success;
     }
 
+    // Linear combination with zero, unit, small and random coefficients
+    const size_t num_cts = 8;
+    std::vector<LWE::ciphertext> cts;
+    std::vector<Fr> vals;
+    for (size_t k = 0; k < num_cts; k++) {
+        Fr v = Fr::random_element();
+        LWE::plaintext pt(NTL::INIT_SIZE, LWE::pt_dim);
+        for (uint32_t i = 0; i < LWE::pt_dim; i++) {
+            pt[i] = v.as_ZZ_p();
+        }
+        cts.emplace_back(LWE::encrypt(LWE_sk, pt));
+        vals.emplace_back(v);
+    }
+
+    std::vector<uint64_t> coeffs = { 0, 1, 1, 2, 0, LWE::p_int - 1, (uint64_t) c1, (uint64_t) c2 };
+    Fr expected = Fr::zero();
+    for (size_t k = 0; k < num_cts; k++) {
+        expected += Fr(coeffs[k]) * vals[k];
+    }
+
+    const LWE::lincomb_strategy strategies[] = { LWE::lincomb_strategy::automatic,
+                                                 LWE::lincomb_strategy::dense,
+                                                 LWE::lincomb_strategy::sparse,
+                                                 LWE::lincomb_strategy::bucket };
+    for (LWE::lincomb_strategy strategy : strategies) {
+        LWE::plaintext outlc = LWE::decrypt(LWE_sk, LWE::linear_combination(cts, coeffs, strategy));
+        string check = string("Linear Combination (") + LWE::lincomb_strategy_name(strategy) + ")";
+        for (uint32_t i = 0; i < LWE::pt_dim; i++) {
+            success = check_relation(expected, outlc[i], check, i) && success;
+        }
+    }
+
+    // Linear combination over packed ciphertexts, packed in memory and read
+    // back from their serialization
+    const LWE::packed_ciphertexts packed = LWE::pack_ciphertexts(cts, huge_pages::huge_2mb, numa_node_interleave);
+    std::stringstream serialized;
+    for (size_t k = 0; k < num_cts; k++) {
+        serialized << cts[k];
+    }
+    const LWE::packed_ciphertexts loaded = LWE::read_packed_ciphertexts(serialized, num_cts);
+    success = bool(serialized) && success;
+
+    const LWE::packed_ciphertexts *packings[] = { &packed, &loaded };
+    for (const LWE::packed_ciphertexts *p : packings) {
+        LWE::plaintext outlc = LWE::decrypt(LWE_sk, LWE::linear_combination(*p, coeffs));
+        for (uint32_t i = 0; i < LWE::pt_dim; i++) {
+            success = check_relation(expected, outlc[i], "Linear Combination (packed)", i) && success;
+        }
+    }
+
+    // Tiled and multi-threaded linear combinations over packed ciphertexts
+    const size_t tilings[][2] = { { 0, 4 }, { 64, 1 }, { 100, 3 }, { LWE::ct_dim, 2 } };
+    for (const size_t *tiling : tilings) {
+        LWE::plaintext outlc = LWE::decrypt(LWE_sk, LWE::linear_combination(packed, coeffs, tiling[0], tiling[1]));
+        for (uint32_t i = 0; i < LWE::pt_dim; i++) {
+            success = check_relation(expected, outlc[i], "Linear Combination (packed, tiled)", i) && success;
+        }
+    }
+
+    // Tuning profiles: round trip, and profiles for other LWE parameters
+    {
+        LWE::tuning_profile profile;
+        profile.cpu = "Test CPU @ 1.00GHz";
+        profile.has_backend = true;
+        profile.kernel_backend = LWE::backend::native;
+        profile.lincomb_tile_words = 128;
+        profile.lincomb_threads = 3;
+        profile.lincomb_mul_cost = 2.5;
+        profile.encryption_threads = 4;
+        profile.encryption_batch = 32;
+
+        std::stringstream text;
+        LWE::write_tuning_profile(text, profile);
+
+        LWE::tuning_profile loaded_profile;
+        string error;
+        const bool read = LWE::read_tuning_profile(text, loaded_profile, error);
+        if (!read || loaded_profile.cpu != profile.cpu || !loaded_profile.has_backend || loaded_profile.kernel_backend != profile.kernel_backend ||
+            loaded_profile.lincomb_tile_words != 128 || loaded_profile.lincomb_threads != 3 ||
+            loaded_profile.lincomb_mul_cost != 2.5 || loaded_profile.encryption_threads != 4 ||
+            loaded_profile.encryption_batch != 32) {
+            cout << "Tuning profile round trip failed: " << error << endl;
+            success = false;
+        }
+
+        const string lwe_n_line = "lwe_n = " + std::to_string(LWE::n) + "\n";
+        string other_text = text.str();
+        other_text.replace(other_text.find(lwe_n_line), lwe_n_line.size(), "lwe_n = " + std::to_string(LWE::n + 1) + "\n");
+        std::stringstream other(other_text);
+        if (LWE::read_tuning_profile(other, loaded_profile, error)) {
+            cout << "Tuning profile for other LWE parameters accepted" << endl;
+            success = false;
+        }
+
+        std::stringstream duplicate(text.str() + lwe_n_line);
+        if (LWE::read_tuning_profile(duplicate, loaded_profile, error)) {
+            cout << "Tuning profile with a duplicate LWE parameter accepted" << endl;
+            success = false;
+        }
+    }
+
+    // Encryption with precomputed encryptions of zero, from a full pool
+    {
+        const size_t num_threads = LWE::encryption_pool::threads_supported() ? 2 : 1;
+        LWE::encryption_pool pool(std::make_shared<const LWE::secret_key>(LWE_sk), 2, num_threads);
+        pool.wait_full();
+        success = (pool.size() == 2) && success;
+
+        for (size_t k = 0; k < 3; k++) {
+            LWE::plaintext outpool = LWE::decrypt(LWE_sk, LWE::encrypt(pool, d1i));
+            for (uint32_t i = 0; i < LWE::pt_dim; i++) {
+                success = check_relation(d1[i], outpool[i], "Pool Encryption", i) && success;
+            }
+        }
+    }
+
+    // Without background threads the pool never fills: every encryption is a
+    // miss, computed online
+    {
+        LWE::encryption_pool pool(std::make_shared<const LWE::secret_key>(LWE_sk), 2, 0);
+        for (size_t k = 0; k < 3; k++) {
+            LWE::plaintext outpool = LWE::decrypt(LWE_sk, LWE::encrypt(pool, d1i));
+            for (uint32_t i = 0; i < LWE::pt_dim; i++) {
+                success = check_relation(d1[i], outpool[i], "Pool Encryption (miss)", i) && success;
+            }
+        }
+        if (pool.size() != 0 || pool.misses() != 3) {
+            cout << "Encryption pool without threads: " << pool.misses() << " misses, expected 3" << endl;
+            success = false;
+        }
+    }
+
+    // Kernels of every available backend against the ntl backend
+    const LWE::backend backends[] = { LWE::backend::native, LWE::backend::avx2, LWE::backend::avx512 };
+    for (LWE::backend b : backends) {
+        if (!LWE::backend_available(b)) {
+            cout << "Backend " << LWE::backend_name(b) << " not available" << endl;
+            continue;
+        }
+        if (!LWE::cross_check_backend(b, 64)) {
+            cout << "Backend " << LWE::backend_name(b) << " differs from the ntl backend" << endl;
+            success = false;
+        }
+    }
+    cout << "Active backend: " << LWE::backend_name(LWE::active_backend()) << endl;
+
     if (success) {
         cout << "All tests passed." << endl;
     }
@@ -0,0 +1,93 @@
+/** @file
+ *****************************************************************************
+
+ Implementation of a minimal message channel over file descriptors.
+
+ See fd_channel.hpp
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#include <cerrno>
+#include <cstdint>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "fd_channel.hpp"
+
+namespace libsnark {
+
+static bool write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        // Do not raise SIGPIPE if the peer has gone away (sockets only)
+        ssize_t written = send(fd, buf, len, MSG_NOSIGNAL);
+        if (written < 0 && errno == ENOTSOCK) {
+            written = write(fd, buf, len);
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        buf += written;
+        len -= written;
+    }
+    return true;
+}
+
+static bool read_all(int fd, char *buf, size_t len) {
+    while (len > 0) {
+        const ssize_t got = read(fd, buf, len);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        buf += got;
+        len -= got;
+    }
+    return true;
+}
+
+void append_uint64(std::string &msg, uint64_t x) {
+    for (size_t i = 0; i < 8; i++) {
+        msg.push_back((char) ((x >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t parse_uint64(const std::string &msg, size_t pos) {
+    uint64_t x = 0;
+    for (size_t i = 0; i < 8; i++) {
+        x |= ((uint64_t) (unsigned char) msg[pos + i]) << (8 * i);
+    }
+    return x;
+}
+
+bool write_message(int fd, const std::string &msg) {
+    std::string header;
+    append_uint64(header, msg.size());
+
+    return write_all(fd, header.data(), 8) && write_all(fd, msg.data(), msg.size());
+}
+
+bool read_message(int fd, std::string &msg, uint64_t max_len) {
+    std::string header(8, '\0');
+    if (!read_all(fd, &header[0], 8)) {
+        return false;
+    }
+
+    const uint64_t len = parse_uint64(header, 0);
+    if (len > max_len) {
+        errno = EMSGSIZE;
+        return false;
+    }
+
+    msg.resize(len);
+    return (len == 0) || read_all(fd, &msg[0], len);
+}
+
+} // libsnark
@@ -0,0 +1,50 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of a minimal message channel over file descriptors (pipes,
+ UNIX domain sockets, or the standard streams of a remote process), used to
+ talk to out-of-process workers.
+
+ Each message is a 64-bit little-endian length followed by that many bytes.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef FD_CHANNEL_HPP_
+#define FD_CHANNEL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace libsnark {
+
+/**
+ * Write the message msg to fd. Returns false if the write fails.
+ */
+bool write_message(int fd, const std::string &msg);
+
+/**
+ * Read one message of at most max_len bytes from fd into msg. Returns false
+ * on end of file, if the read fails, or if the header announces more than
+ * max_len bytes (then errno is EMSGSIZE, nothing is allocated, and the channel
+ * should be closed).
+ */
+bool read_message(int fd, std::string &msg, uint64_t max_len);
+
+/**
+ * Append x to msg as 8 little-endian bytes.
+ */
+void append_uint64(std::string &msg, uint64_t x);
+
+/**
+ * Parse the 8 little-endian bytes of msg at position pos (which must be in
+ * range).
+ */
+uint64_t parse_uint64(const std::string &msg, size_t pos);
+
+} // libsnark
+
+#endif // FD_CHANNEL_HPP_
@@ -0,0 +1,176 @@
+/** @file
+ *****************************************************************************
+
+ Implementation of memory buffers with explicit page size and NUMA placement.
+
+ See numa_memory.hpp
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#include <new>
+#include <sched.h>
+#include <sys/mman.h>
+
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+#include "numa_memory.hpp"
+
+namespace libsnark {
+
+const char* huge_pages_name(huge_pages pages) {
+    switch (pages) {
+        case huge_pages::none:        return "none";
+        case huge_pages::transparent: return "transparent";
+        case huge_pages::huge_2mb:    return "2MB";
+        case huge_pages::huge_1gb:    return "1GB";
+    }
+    return "unknown";
+}
+
+static size_t round_up(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// Map size bytes with reserved huge pages of 2^log_page_size bytes
+static void* map_hugetlb(size_t size, unsigned log_page_size) {
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log_page_size << MAP_HUGE_SHIFT), -1, 0);
+    return (data == MAP_FAILED) ? nullptr : data;
+#else
+    (void) size;
+    (void) log_page_size;
+    return nullptr;
+#endif
+}
+
+static bool numa_supported() {
+#ifdef HAVE_LIBNUMA
+    static const bool supported = (numa_available() >= 0);
+    return supported;
+#else
+    return false;
+#endif
+}
+
+mapped_buffer::mapped_buffer(size_t size, huge_pages pages, int node) :
+    data_(nullptr), size_(size), mapped_size_(0), pages_(huge_pages::none)
+{
+    const size_t size_2mb = size_t(1) << 21;
+    const size_t size_1gb = size_t(1) << 30;
+
+    if (size == 0) {
+        return;
+    }
+
+    // Buffers smaller than half a huge page would waste most of it
+    if (pages == huge_pages::huge_1gb && size >= size_1gb / 2) {
+        mapped_size_ = round_up(size, size_1gb);
+        data_ = map_hugetlb(mapped_size_, 30);
+        pages_ = huge_pages::huge_1gb;
+    }
+    if (data_ == nullptr && (pages == huge_pages::huge_1gb || pages == huge_pages::huge_2mb) && size >= size_2mb / 2) {
+        mapped_size_ = round_up(size, size_2mb);
+        data_ = map_hugetlb(mapped_size_, 21);
+        pages_ = huge_pages::huge_2mb;
+    }
+    if (data_ == nullptr) {
+        mapped_size_ = (pages == huge_pages::none) ? size : round_up(size, size_2mb);
+        data_ = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data_ == MAP_FAILED) {
+            data_ = nullptr;
+            throw std::bad_alloc();
+        }
+
+        pages_ = huge_pages::none;
+#ifdef MADV_HUGEPAGE
+        if (pages != huge_pages::none && madvise(data_, mapped_size_, MADV_HUGEPAGE) == 0) {
+            pages_ = huge_pages::transparent;
+        }
+#endif
+    }
+
+    // Set the placement policy before the pages are first touched
+#ifdef HAVE_LIBNUMA
+    if (numa_supported()) {
+        if (node == numa_node_interleave) {
+            numa_interleave_memory(data_, mapped_size_, numa_all_nodes_ptr);
+        } else if (node >= 0) {
+            numa_tonode_memory(data_, mapped_size_, node);
+        }
+    }
+#else
+    (void) node;
+#endif
+}
+
+mapped_buffer::mapped_buffer(mapped_buffer &&other) :
+    data_(other.data_), size_(other.size_), mapped_size_(other.mapped_size_), pages_(other.pages_)
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_size_ = 0;
+}
+
+mapped_buffer& mapped_buffer::operator=(mapped_buffer &&other) {
+    if (this != &other) {
+        release();
+        data_ = other.data_;
+        size_ = other.size_;
+        mapped_size_ = other.mapped_size_;
+        pages_ = other.pages_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_size_ = 0;
+    }
+    return *this;
+}
+
+mapped_buffer::~mapped_buffer() {
+    release();
+}
+
+void mapped_buffer::release() {
+    if (data_ != nullptr) {
+        munmap(data_, mapped_size_);
+        data_ = nullptr;
+    }
+}
+
+size_t numa_num_nodes() {
+#ifdef HAVE_LIBNUMA
+    if (numa_supported()) {
+        return numa_max_node() + 1;
+    }
+#endif
+    return 1;
+}
+
+int numa_current_node() {
+#ifdef HAVE_LIBNUMA
+    if (numa_supported()) {
+        const int cpu = sched_getcpu();
+        const int node = (cpu >= 0) ? numa_node_of_cpu(cpu) : -1;
+        return (node >= 0) ? node : 0;
+    }
+#endif
+    return 0;
+}
+
+bool numa_pin_thread_to_node(int node) {
+#ifdef HAVE_LIBNUMA
+    if (numa_supported()) {
+        return numa_run_on_node(node) == 0;
+    }
+#else
+    (void) node;
+#endif
+    return false;
+}
+
+} // libsnark
@@ -0,0 +1,97 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of memory buffers with explicit page size and NUMA placement, and
+ of helpers to query the NUMA topology and pin threads to NUMA nodes.
+
+ Buffers are mapped with mmap. Huge pages are requested with MAP_HUGETLB (2 MB
+ or 1 GB pages, which must be reserved by the administrator, e.g., through
+ /proc/sys/vm/nr_hugepages) or with madvise(MADV_HUGEPAGE) (transparent huge
+ pages). If a request cannot be satisfied, the allocation falls back to the
+ next smaller page size, down to regular pages.
+
+ NUMA placement uses libnuma if the library was found at build time
+ (HAVE_LIBNUMA) and is usable at run time. Otherwise, the host is treated as a
+ single node, and placement requests are ignored.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef NUMA_MEMORY_HPP_
+#define NUMA_MEMORY_HPP_
+
+#include <cstddef>
+
+namespace libsnark {
+
+enum class huge_pages {
+    none,        // regular pages
+    transparent, // transparent huge pages (madvise)
+    huge_2mb,    // reserved 2 MB pages
+    huge_1gb     // reserved 1 GB pages
+};
+
+const char* huge_pages_name(huge_pages pages);
+
+// NUMA node arguments of mapped_buffer that are not node numbers
+const int numa_node_any = -1;        // no placement (first touch)
+const int numa_node_interleave = -2; // interleave pages across all nodes
+
+/**
+ * A buffer of memory mapped with the requested page size and NUMA placement.
+ * The contents are zero-initialized; the pages are placed when first written.
+ */
+class mapped_buffer {
+public:
+    mapped_buffer() : data_(nullptr), size_(0), mapped_size_(0), pages_(huge_pages::none) {};
+
+    /**
+     * Map size bytes, with pages of at most the given size, placed on node
+     * (or according to numa_node_any or numa_node_interleave). Throws
+     * std::bad_alloc if the memory cannot be mapped.
+     */
+    mapped_buffer(size_t size, huge_pages pages, int node);
+
+    mapped_buffer(const mapped_buffer &other) = delete;
+    mapped_buffer& operator=(const mapped_buffer &other) = delete;
+    mapped_buffer(mapped_buffer &&other);
+    mapped_buffer& operator=(mapped_buffer &&other);
+    ~mapped_buffer();
+
+    void* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // The page size that was obtained
+    huge_pages pages() const { return pages_; }
+
+private:
+    void *data_;
+    size_t size_;
+    size_t mapped_size_;
+    huge_pages pages_;
+
+    void release();
+};
+
+/**
+ * The number of NUMA nodes (1 if NUMA is not supported).
+ */
+size_t numa_num_nodes();
+
+/**
+ * The NUMA node of the CPU the calling thread runs on (0 if NUMA is not
+ * supported).
+ */
+int numa_current_node();
+
+/**
+ * Restrict the calling thread to the CPUs of node. Returns false if NUMA is not
+ * supported or the thread cannot be pinned.
+ */
+bool numa_pin_thread_to_node(int node);
+
+} // libsnark
+
+#endif // NUMA_MEMORY_HPP_
@@ -0,0 +1,162 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of interfaces for a compact, immutable representation of a R1CS
+ constraint system, and of the R1CS-to-QAP reduction over it.
+
+ The constraint system is stored as three sparse matrices A, B, C in
+ compressed sparse row (CSR) layout: row i of A holds the terms of the
+ linear combination a of constraint i, with 32-bit variable indices (index 0
+ is the constant 1) and 32-bit coefficients in [0, p). Compared to libsnark's
+ r1cs_constraint_system (a vector of constraints, each holding three vectors of
+ linear_term objects), this uses 8 bytes per term plus 8 bytes of row offset
+ per row, and the witness map iterates over contiguous arrays.
+
+ This includes:
+ - class for a CSR matrix
+ - class for a CSR constraint system
+ - R1CS-to-QAP instance map (with evaluation at a point t)
+ - R1CS-to-QAP witness map
+ - differences between constraint systems, and evaluation of the QAP
+   polynomials of a subset of the variables (for incremental key generation)
+
+ The reductions are the ones of libsnark's r1cs_to_qap (see [GGPR13] and
+ [BCGTV13]), and produce the same QAP instances and witnesses.
+
+ References:
+
+ [GGPR13]:  Rosario Gennaro, Craig Gentry, Bryan Parno, and Mariana Raykova.
+            Quadratic Span Programs and Succinct NIZKs without PCPs. In
+            Eurocrypt, 2013.
+
+ [BCGTV13]: Eli Ben-Sasson, Alessandro Chiesa, Daniel Genkin, Eran Tromer, and Madars Virza.
+            SNARKs for C: Verifying Program Executions Succinctly and in Zero Knowledge. In
+            Crypto, 2013.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef R1CS_CSR_CONSTRAINT_SYSTEM_HPP_
+#define R1CS_CSR_CONSTRAINT_SYSTEM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <libsnark/relations/arithmetic_programs/qap/qap.hpp>
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/r1cs.hpp>
+
+namespace libsnark {
+
+/**
+ * A sparse matrix in compressed sparse row layout.
+ */
+class r1cs_csr_matrix {
+public:
+    // Row i consists of the entries row_offsets[i], ..., row_offsets[i + 1] - 1
+    std::vector<uint64_t> row_offsets;
+    std::vector<uint32_t> columns;
+    std::vector<uint32_t> coefficients;
+
+    r1cs_csr_matrix() : row_offsets(1, 0) {}
+
+    size_t num_rows() const { return row_offsets.size() - 1; }
+    size_t num_entries() const { return columns.size(); }
+    size_t size_in_bytes() const
+    {
+        return row_offsets.size() * sizeof(uint64_t) + columns.size() * sizeof(uint32_t) + coefficients.size() * sizeof(uint32_t);
+    }
+};
+
+/**
+ * A compact, immutable R1CS constraint system.
+ */
+template<typename FieldT>
+class r1cs_csr_constraint_system {
+public:
+    size_t primary_input_size;
+    size_t auxiliary_input_size;
+
+    r1cs_csr_matrix A;
+    r1cs_csr_matrix B;
+    r1cs_csr_matrix C;
+
+    r1cs_csr_constraint_system() = default;
+    explicit r1cs_csr_constraint_system(const r1cs_constraint_system<FieldT> &cs);
+
+    size_t num_inputs() const { return primary_input_size; }
+    size_t num_variables() const { return primary_input_size + auxiliary_input_size; }
+    size_t num_constraints() const { return A.num_rows(); }
+    size_t size_in_bytes() const { return A.size_in_bytes() + B.size_in_bytes() + C.size_in_bytes(); }
+
+    /**
+     * Compute the full variable assignment (1, primary_input, auxiliary_input)
+     * as native integers.
+     */
+    std::vector<uint32_t> native_assignment(const r1cs_primary_input<FieldT> &primary_input,
+                                            const r1cs_auxiliary_input<FieldT> &auxiliary_input) const;
+
+    /**
+     * Evaluate row i of M at the native assignment (a value in [0, p)).
+     */
+    uint64_t evaluate(const r1cs_csr_matrix &M, size_t i, const std::vector<uint32_t> &assignment) const;
+
+    bool is_satisfied(const r1cs_primary_input<FieldT> &primary_input,
+                      const r1cs_auxiliary_input<FieldT> &auxiliary_input) const;
+};
+
+/**
+ * Instance map for the R1CS-to-QAP reduction followed by evaluation of the
+ * resulting QAP instance (see r1cs_to_qap_instance_map_with_evaluation).
+ */
+template<typename FieldT>
+qap_instance_evaluation<FieldT> r1cs_csr_to_qap_instance_map_with_evaluation(const r1cs_csr_constraint_system<FieldT> &cs,
+                                                                             const FieldT &t);
+
+/**
+ * Witness map for the R1CS-to-QAP reduction (see r1cs_to_qap_witness_map).
+ */
+template<typename FieldT>
+qap_witness<FieldT> r1cs_csr_to_qap_witness_map(const r1cs_csr_constraint_system<FieldT> &cs,
+                                                const r1cs_primary_input<FieldT> &primary_input,
+                                                const r1cs_auxiliary_input<FieldT> &auxiliary_input,
+                                                const FieldT &d1,
+                                                const FieldT &d2,
+                                                const FieldT &d3);
+
+/**
+ * The indices (in increasing order) of the constraints that differ between
+ * old_cs and new_cs, including the constraints present in only one of them.
+ */
+template<typename FieldT>
+std::vector<size_t> r1cs_csr_changed_constraints(const r1cs_csr_constraint_system<FieldT> &old_cs,
+                                                 const r1cs_csr_constraint_system<FieldT> &new_cs);
+
+/**
+ * The variables (in increasing order) that appear in the constraints of cs with
+ * the given indices. Indices beyond the constraints of cs are ignored.
+ */
+template<typename FieldT>
+std::vector<size_t> r1cs_csr_constraint_variables(const r1cs_csr_constraint_system<FieldT> &cs,
+                                                  const std::vector<size_t> &constraints);
+
+/**
+ * Evaluate at t the QAP polynomials A_v, B_v, C_v of the R1CS-to-QAP reduction
+ * (see r1cs_csr_to_qap_instance_map_with_evaluation) for the variables v in
+ * vars only. On return, At[k], Bt[k], Ct[k] are the evaluations for vars[k].
+ */
+template<typename FieldT>
+void r1cs_csr_evaluate_variables(const r1cs_csr_constraint_system<FieldT> &cs,
+                                 const FieldT &t,
+                                 const std::vector<size_t> &vars,
+                                 std::vector<FieldT> &At,
+                                 std::vector<FieldT> &Bt,
+                                 std::vector<FieldT> &Ct);
+
+} // libsnark
+
+#include <lattice_snarg/r1cs_lattice_snarg/r1cs_csr_constraint_system.tcc>
+
+#endif // R1CS_CSR_CONSTRAINT_SYSTEM_HPP_
@@ -0,0 +1,418 @@
+/** @file
+*****************************************************************************
+
+Implementation of interfaces for a compact, immutable representation of a
+R1CS constraint system, and of the R1CS-to-QAP reduction over it.
+
+See r1cs_csr_constraint_system.hpp
+
+*****************************************************************************
+* @author     Samir Menon, Brennan Shacklett, and David J. Wu
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+#ifndef R1CS_CSR_CONSTRAINT_SYSTEM_TCC_
+#define R1CS_CSR_CONSTRAINT_SYSTEM_TCC_
+
+#include <algorithm>
+#include <cassert>
+
+#include <libff/common/profiling.hpp>
+#include <libfqfft/evaluation_domain/get_evaluation_domain.hpp>
+
+namespace libsnark {
+
+template<typename FieldT>
+static void append_csr_row(r1cs_csr_matrix &M, const linear_combination<FieldT> &lc) {
+    for (const linear_term<FieldT> &term : lc.terms) {
+        assert(term.index < (1ul << 32));
+        M.columns.emplace_back(term.index);
+        M.coefficients.emplace_back(term.coeff.as_ulong());
+    }
+    M.row_offsets.emplace_back(M.columns.size());
+}
+
+template<typename FieldT>
+r1cs_csr_constraint_system<FieldT>::r1cs_csr_constraint_system(const r1cs_constraint_system<FieldT> &cs) :
+    primary_input_size(cs.primary_input_size),
+    auxiliary_input_size(cs.auxiliary_input_size)
+{
+    assert(FieldT::field_char() < (1ul << 32));
+
+    A.row_offsets.reserve(cs.num_constraints() + 1);
+    B.row_offsets.reserve(cs.num_constraints() + 1);
+    C.row_offsets.reserve(cs.num_constraints() + 1);
+    for (const r1cs_constraint<FieldT> &constraint : cs.constraints) {
+        append_csr_row(A, constraint.a);
+        append_csr_row(B, constraint.b);
+        append_csr_row(C, constraint.c);
+    }
+}
+
+template<typename FieldT>
+std::vector<uint32_t> r1cs_csr_constraint_system<FieldT>::native_assignment(const r1cs_primary_input<FieldT> &primary_input,
+                                                                            const r1cs_auxiliary_input<FieldT> &auxiliary_input) const
+{
+    assert(primary_input.size() == primary_input_size);
+    assert(auxiliary_input.size() == auxiliary_input_size);
+
+    std::vector<uint32_t> assignment;
+    assignment.reserve(num_variables() + 1);
+    assignment.emplace_back(1);
+    for (const FieldT &x : primary_input) {
+        assignment.emplace_back(x.as_ulong());
+    }
+    for (const FieldT &x : auxiliary_input) {
+        assignment.emplace_back(x.as_ulong());
+    }
+
+    return assignment;
+}
+
+template<typename FieldT>
+uint64_t r1cs_csr_constraint_system<FieldT>::evaluate(const r1cs_csr_matrix &M, size_t i, const std::vector<uint32_t> &assignment) const
+{
+    // Number of products that can be accumulated (on top of a value below p)
+    // before reducing
+    const uint64_t p = FieldT::field_char();
+    const uint64_t batch = (UINT64_MAX - p) / ((p - 1) * (p - 1));
+
+    uint64_t acc = 0;
+    uint64_t k = M.row_offsets[i];
+    const uint64_t end = M.row_offsets[i + 1];
+    while (k < end) {
+        const uint64_t batch_end = std::min(end, k + batch);
+        for (; k < batch_end; k++) {
+            acc += (uint64_t) M.coefficients[k] * assignment[M.columns[k]];
+        }
+        acc %= p;
+    }
+
+    return acc;
+}
+
+template<typename FieldT>
+bool r1cs_csr_constraint_system<FieldT>::is_satisfied(const r1cs_primary_input<FieldT> &primary_input,
+                                                      const r1cs_auxiliary_input<FieldT> &auxiliary_input) const
+{
+    if (primary_input.size() != primary_input_size || auxiliary_input.size() != auxiliary_input_size) {
+        return false;
+    }
+
+    const uint64_t p = FieldT::field_char();
+    const std::vector<uint32_t> assignment = native_assignment(primary_input, auxiliary_input);
+    for (size_t i = 0; i < num_constraints(); i++) {
+        const uint64_t a = evaluate(A, i, assignment);
+        const uint64_t b = evaluate(B, i, assignment);
+        const uint64_t c = evaluate(C, i, assignment);
+
+        if ((a * b) % p != c) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename FieldT>
+qap_instance_evaluation<FieldT> r1cs_csr_to_qap_instance_map_with_evaluation(const r1cs_csr_constraint_system<FieldT> &cs,
+                                                                             const FieldT &t)
+{
+    libff::enter_block("Call to r1cs_csr_to_qap_instance_map_with_evaluation");
+
+    const std::shared_ptr<libfqfft::evaluation_domain<FieldT> > domain = libfqfft::get_evaluation_domain<FieldT>(cs.num_constraints() + cs.num_inputs() + 1);
+
+    std::vector<FieldT> At(cs.num_variables() + 1, FieldT::zero());
+    std::vector<FieldT> Bt(cs.num_variables() + 1, FieldT::zero());
+    std::vector<FieldT> Ct(cs.num_variables() + 1, FieldT::zero());
+    std::vector<FieldT> Ht;
+    Ht.reserve(domain->m + 1);
+
+    const FieldT Zt = domain->compute_vanishing_polynomial(t);
+
+    libff::enter_block("Compute evaluations of A, B, C");
+    const std::vector<FieldT> u = domain->evaluate_all_lagrange_polynomials(t);
+
+    /* account for the additional constraints input_i * 0 = 0 */
+    for (size_t i = 0; i <= cs.num_inputs(); i++) {
+        At[i] = u[cs.num_constraints() + i];
+    }
+
+    /* account for all other constraints */
+    for (size_t i = 0; i < cs.num_constraints(); i++) {
+        for (uint64_t k = cs.A.row_offsets[i]; k < cs.A.row_offsets[i + 1]; k++) {
+            At[cs.A.columns[k]] += u[i] * FieldT(cs.A.coefficients[k]);
+        }
+        for (uint64_t k = cs.B.row_offsets[i]; k < cs.B.row_offsets[i + 1]; k++) {
+            Bt[cs.B.columns[k]] += u[i] * FieldT(cs.B.coefficients[k]);
+        }
+        for (uint64_t k = cs.C.row_offsets[i]; k < cs.C.row_offsets[i + 1]; k++) {
+            Ct[cs.C.columns[k]] += u[i] * FieldT(cs.C.coefficients[k]);
+        }
+    }
+    libff::leave_block("Compute evaluations of A, B, C");
+
+    libff::enter_block("Compute evaluations of H");
+    FieldT ti = FieldT::one();
+    for (size_t i = 0; i < domain->m + 1; i++) {
+        Ht.emplace_back(ti);
+        ti *= t;
+    }
+    libff::leave_block("Compute evaluations of H");
+
+    libff::leave_block("Call to r1cs_csr_to_qap_instance_map_with_evaluation");
+
+    return qap_instance_evaluation<FieldT>(domain,
+                                           cs.num_variables(),
+                                           domain->m,
+                                           cs.num_inputs(),
+                                           t,
+                                           std::move(At),
+                                           std::move(Bt),
+                                           std::move(Ct),
+                                           std::move(Ht),
+                                           Zt);
+}
+
+template<typename FieldT>
+qap_witness<FieldT> r1cs_csr_to_qap_witness_map(const r1cs_csr_constraint_system<FieldT> &cs,
+                                                const r1cs_primary_input<FieldT> &primary_input,
+                                                const r1cs_auxiliary_input<FieldT> &auxiliary_input,
+                                                const FieldT &d1,
+                                                const FieldT &d2,
+                                                const FieldT &d3)
+{
+    libff::enter_block("Call to r1cs_csr_to_qap_witness_map");
+
+#ifdef DEBUG
+    assert(cs.is_satisfied(primary_input, auxiliary_input));
+#endif
+
+    const std::shared_ptr<libfqfft::evaluation_domain<FieldT> > domain = libfqfft::get_evaluation_domain<FieldT>(cs.num_constraints() + cs.num_inputs() + 1);
+
+    r1cs_variable_assignment<FieldT> full_variable_assignment = primary_input;
+    full_variable_assignment.insert(full_variable_assignment.end(), auxiliary_input.begin(), auxiliary_input.end());
+
+    const std::vector<uint32_t> assignment = cs.native_assignment(primary_input, auxiliary_input);
+
+    libff::enter_block("Compute evaluation of polynomials A, B on set S");
+    std::vector<FieldT> aA(domain->m, FieldT::zero()), aB(domain->m, FieldT::zero());
+
+    /* account for the additional constraints input_i * 0 = 0 */
+    for (size_t i = 0; i <= cs.num_inputs(); i++) {
+        aA[i + cs.num_constraints()] = FieldT(assignment[i]);
+    }
+
+    /* account for all other constraints */
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < cs.num_constraints(); i++) {
+        aA[i] = FieldT(cs.evaluate(cs.A, i, assignment));
+        aB[i] = FieldT(cs.evaluate(cs.B, i, assignment));
+    }
+    libff::leave_block("Compute evaluation of polynomials A, B on set S");
+
+    libff::enter_block("Compute coefficients of polynomial A");
+    domain->iFFT(aA);
+    libff::leave_block("Compute coefficients of polynomial A");
+
+    libff::enter_block("Compute coefficients of polynomial B");
+    domain->iFFT(aB);
+    libff::leave_block("Compute coefficients of polynomial B");
+
+    libff::enter_block("Compute ZK-patch");
+    std::vector<FieldT> coefficients_for_H(domain->m + 1, FieldT::zero());
+    /* add coefficients of the polynomial (d2*A + d1*B - d3) + d1*d2*Z */
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < domain->m; i++) {
+        coefficients_for_H[i] = d2*aA[i] + d1*aB[i];
+    }
+    coefficients_for_H[0] -= d3;
+    domain->add_poly_Z(d1*d2, coefficients_for_H);
+    libff::leave_block("Compute ZK-patch");
+
+    libff::enter_block("Compute evaluation of polynomial A on set T");
+    domain->cosetFFT(aA, FieldT::multiplicative_generator);
+    libff::leave_block("Compute evaluation of polynomial A on set T");
+
+    libff::enter_block("Compute evaluation of polynomial B on set T");
+    domain->cosetFFT(aB, FieldT::multiplicative_generator);
+    libff::leave_block("Compute evaluation of polynomial B on set T");
+
+    libff::enter_block("Compute evaluation of polynomial H on set T");
+    std::vector<FieldT> &H_tmp = aA; // can overwrite aA because it is not used later
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < domain->m; i++) {
+        H_tmp[i] = aA[i]*aB[i];
+    }
+    std::vector<FieldT>().swap(aB); // destroy aB
+
+    libff::enter_block("Compute evaluation of polynomial C on set S");
+    std::vector<FieldT> aC(domain->m, FieldT::zero());
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < cs.num_constraints(); i++) {
+        aC[i] = FieldT(cs.evaluate(cs.C, i, assignment));
+    }
+    libff::leave_block("Compute evaluation of polynomial C on set S");
+
+    libff::enter_block("Compute coefficients of polynomial C");
+    domain->iFFT(aC);
+    libff::leave_block("Compute coefficients of polynomial C");
+
+    libff::enter_block("Compute evaluation of polynomial C on set T");
+    domain->cosetFFT(aC, FieldT::multiplicative_generator);
+    libff::leave_block("Compute evaluation of polynomial C on set T");
+
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < domain->m; i++) {
+        H_tmp[i] = (H_tmp[i]-aC[i]);
+    }
+
+    libff::enter_block("Divide by Z on set T");
+    domain->divide_by_Z_on_coset(H_tmp);
+    libff::leave_block("Divide by Z on set T");
+
+    libff::leave_block("Compute evaluation of polynomial H on set T");
+
+    libff::enter_block("Compute coefficients of polynomial H");
+    domain->icosetFFT(H_tmp, FieldT::multiplicative_generator);
+    libff::leave_block("Compute coefficients of polynomial H");
+
+    libff::enter_block("Compute sum of H and ZK-patch");
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < domain->m; i++) {
+        coefficients_for_H[i] += H_tmp[i];
+    }
+    libff::leave_block("Compute sum of H and ZK-patch");
+
+    libff::leave_block("Call to r1cs_csr_to_qap_witness_map");
+
+    return qap_witness<FieldT>(cs.num_variables(),
+                               domain->m,
+                               cs.num_inputs(),
+                               d1,
+                               d2,
+                               d3,
+                               full_variable_assignment,
+                               std::move(coefficients_for_H));
+}
+
+// Whether row i of M and row j of N hold the same terms
+inline bool same_csr_row(const r1cs_csr_matrix &M, size_t i, const r1cs_csr_matrix &N, size_t j) {
+    const uint64_t len = M.row_offsets[i + 1] - M.row_offsets[i];
+    if (len != N.row_offsets[j + 1] - N.row_offsets[j]) {
+        return false;
+    }
+
+    return std::equal(M.columns.begin() + M.row_offsets[i], M.columns.begin() + M.row_offsets[i + 1],
+                      N.columns.begin() + N.row_offsets[j]) &&
+           std::equal(M.coefficients.begin() + M.row_offsets[i], M.coefficients.begin() + M.row_offsets[i + 1],
+                      N.coefficients.begin() + N.row_offsets[j]);
+}
+
+template<typename FieldT>
+std::vector<size_t> r1cs_csr_changed_constraints(const r1cs_csr_constraint_system<FieldT> &old_cs,
+                                                 const r1cs_csr_constraint_system<FieldT> &new_cs)
+{
+    const size_t num_common = std::min(old_cs.num_constraints(), new_cs.num_constraints());
+    const size_t num_total = std::max(old_cs.num_constraints(), new_cs.num_constraints());
+
+    std::vector<size_t> changed;
+    for (size_t i = 0; i < num_common; i++) {
+        if (!same_csr_row(old_cs.A, i, new_cs.A, i) ||
+            !same_csr_row(old_cs.B, i, new_cs.B, i) ||
+            !same_csr_row(old_cs.C, i, new_cs.C, i)) {
+            changed.emplace_back(i);
+        }
+    }
+    for (size_t i = num_common; i < num_total; i++) {
+        changed.emplace_back(i);
+    }
+
+    return changed;
+}
+
+template<typename FieldT>
+std::vector<size_t> r1cs_csr_constraint_variables(const r1cs_csr_constraint_system<FieldT> &cs,
+                                                  const std::vector<size_t> &constraints)
+{
+    std::vector<size_t> vars;
+    for (size_t i : constraints) {
+        if (i >= cs.num_constraints()) {
+            continue;
+        }
+
+        const r1cs_csr_matrix *matrices[] = { &cs.A, &cs.B, &cs.C };
+        for (const r1cs_csr_matrix *M : matrices) {
+            vars.insert(vars.end(), M->columns.begin() + M->row_offsets[i], M->columns.begin() + M->row_offsets[i + 1]);
+        }
+    }
+
+    std::sort(vars.begin(), vars.end());
+    vars.erase(std::unique(vars.begin(), vars.end()), vars.end());
+    return vars;
+}
+
+template<typename FieldT>
+void r1cs_csr_evaluate_variables(const r1cs_csr_constraint_system<FieldT> &cs,
+                                 const FieldT &t,
+                                 const std::vector<size_t> &vars,
+                                 std::vector<FieldT> &At,
+                                 std::vector<FieldT> &Bt,
+                                 std::vector<FieldT> &Ct)
+{
+    const std::shared_ptr<libfqfft::evaluation_domain<FieldT> > domain = libfqfft::get_evaluation_domain<FieldT>(cs.num_constraints() + cs.num_inputs() + 1);
+    const std::vector<FieldT> u = domain->evaluate_all_lagrange_polynomials(t);
+
+    // position[v] is the index of v in vars, or -1
+    std::vector<int64_t> position(cs.num_variables() + 1, -1);
+    for (size_t k = 0; k < vars.size(); k++) {
+        assert(vars[k] <= cs.num_variables());
+        position[vars[k]] = k;
+    }
+
+    At.assign(vars.size(), FieldT::zero());
+    Bt.assign(vars.size(), FieldT::zero());
+    Ct.assign(vars.size(), FieldT::zero());
+
+    /* account for the additional constraints input_i * 0 = 0 */
+    for (size_t i = 0; i <= cs.num_inputs(); i++) {
+        if (position[i] >= 0) {
+            At[position[i]] = u[cs.num_constraints() + i];
+        }
+    }
+
+    /* account for all other constraints, skipping the other variables */
+    for (size_t i = 0; i < cs.num_constraints(); i++) {
+        for (uint64_t k = cs.A.row_offsets[i]; k < cs.A.row_offsets[i + 1]; k++) {
+            if (position[cs.A.columns[k]] >= 0) {
+                At[position[cs.A.columns[k]]] += u[i] * FieldT(cs.A.coefficients[k]);
+            }
+        }
+        for (uint64_t k = cs.B.row_offsets[i]; k < cs.B.row_offsets[i + 1]; k++) {
+            if (position[cs.B.columns[k]] >= 0) {
+                Bt[position[cs.B.columns[k]]] += u[i] * FieldT(cs.B.coefficients[k]);
+            }
+        }
+        for (uint64_t k = cs.C.row_offsets[i]; k < cs.C.row_offsets[i + 1]; k++) {
+            if (position[cs.C.columns[k]] >= 0) {
+                Ct[position[cs.C.columns[k]]] += u[i] * FieldT(cs.C.coefficients[k]);
+            }
+        }
+    }
+}
+
+} // libsnark
+
+#endif // R1CS_CSR_CONSTRAINT_SYSTEM_TCC_
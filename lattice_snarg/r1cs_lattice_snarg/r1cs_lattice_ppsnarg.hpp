@@ -5,16 +5,36 @@
 
  This includes:
  - class for common reference string (CRS)
+ - class for processed CRS
  - class for secret verification key
+ - class for processed secret verification key
  - class for key pair (CRS & verification key)
  - class for proof
  - generator algorithm
+ - multi-circuit generator algorithm
+ - incremental generator algorithm
  - prover algorithm
+ - online prover algorithm
  - verifier algorithm
+ - online verifier algorithm
 
  The implementation instantiates (a modification of) the lattice-based SNARG
  construction from [BISW17] using the QAP-based linear PCP of [BCGTV13].
 
+ Thread safety: the generator, prover and verifier algorithms can run
+ concurrently on different threads of one process, including several provers
+ sharing one (processed) CRS and several verifiers sharing one (processed) verification
+ key. All NTL arithmetic goes through the thread-local moduli installed by
+ LWE and NTLFp_model (see lwe.hpp and ntlfp.hpp). The callers must:
+ - call ppT::init_public_params() once, before starting any threads;
+ - set libff::inhibit_profiling_counters (and, to avoid interleaved output,
+   libff::inhibit_profiling_info), since libff's profiling state is global;
+ - not modify a CRS or verification key while it is in use, and copy
+   verification keys (which hold NTL matrices) on a thread with a current
+   ZZ_p modulus, or before starting any threads.
+ The online verifier depends on neither the NTL modulus nor libff's profiling
+ state.
+
  Acronyms:
 
  - R1CS = "Rank-1 Constraint Systems"
@@ -42,6 +62,9 @@ References:
 #include <libff/algebra/curves/public_params.hpp>
 #include <libsnark/relations/constraint_satisfaction_problems/r1cs/r1cs.hpp>
 #include <lattice_snarg/algebra/lattice/lwe.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_native.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_pool.hpp>
+#include <lattice_snarg/common/numa_memory.hpp>
 #include <lattice_snarg/r1cs_lattice_snarg/r1cs_lattice_ppsnarg_params.hpp>
 
 namespace libsnark {
@@ -61,27 +84,87 @@ template<typename ppT>
 std::istream& operator>>(std::istream &in, r1cs_lattice_ppsnarg_crs<ppT> &crs);
 
 /**
- * The common reference string
+ * The common reference string.
+ *
+ * The constraint system is shared (e.g., between the CRS and copies of it) and
+ * immutable, and is stored in the compact CSR layout that the prover's witness
+ * map iterates over.
  */
 template<typename ppT>
 class r1cs_lattice_ppsnarg_crs {
 public:
     std::vector<LWE::ciphertext> enc_queries;
 
-    r1cs_lattice_ppsnarg_constraint_system<ppT> constraint_system;
+    std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > constraint_system;
 
     r1cs_lattice_ppsnarg_crs() {};
     r1cs_lattice_ppsnarg_crs<ppT>& operator=(const r1cs_lattice_ppsnarg_crs<ppT> &other) = default;
     r1cs_lattice_ppsnarg_crs(const r1cs_lattice_ppsnarg_crs<ppT> &other) = default;
     r1cs_lattice_ppsnarg_crs(r1cs_lattice_ppsnarg_crs<ppT> &&other) = default;
     r1cs_lattice_ppsnarg_crs(std::vector<LWE::ciphertext> &&enc_queries,
-                             const r1cs_lattice_ppsnarg_constraint_system<ppT> &constraint_system) :
+                             const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &constraint_system) :
         enc_queries(std::move(enc_queries)),
         constraint_system(constraint_system)
     {};
 };
 
 
+/******************************* Processed CRS *******************************/
+
+/**
+ * NUMA placement of the encrypted queries of a processed CRS.
+ */
+enum class r1cs_lattice_ppsnarg_crs_numa_policy {
+    local,      // one copy, on the node(s) of the processing thread
+    interleave, // one copy, with pages interleaved across all nodes
+    replicate   // one copy per node
+};
+
+/**
+ * Memory placement of a processed CRS.
+ */
+class r1cs_lattice_ppsnarg_crs_placement {
+public:
+    huge_pages pages;
+    r1cs_lattice_ppsnarg_crs_numa_policy numa_policy;
+
+    r1cs_lattice_ppsnarg_crs_placement(huge_pages pages = huge_pages::transparent,
+                                       r1cs_lattice_ppsnarg_crs_numa_policy numa_policy = r1cs_lattice_ppsnarg_crs_numa_policy::interleave) :
+        pages(pages),
+        numa_policy(numa_policy)
+    {};
+};
+
+/**
+ * A processed CRS for the R1CS ppSNARG.
+ *
+ * The prover streams through all encrypted queries for every proof. Compared
+ * to a (non-processed) CRS, a processed CRS stores the encrypted queries packed
+ * in contiguous native words, backed by huge pages where available, and either
+ * interleaved across NUMA nodes or replicated on every node. With replication,
+ * the online prover reads the copy on the node of the calling thread, so
+ * prover threads should be pinned to nodes (see numa_pin_thread_to_node).
+ */
+template<typename ppT>
+class r1cs_lattice_ppsnarg_processed_crs {
+public:
+    // One copy, or one copy per NUMA node (indexed by node)
+    std::vector<LWE::packed_ciphertexts> enc_queries;
+
+    std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > constraint_system;
+
+    r1cs_lattice_ppsnarg_processed_crs() = default;
+    r1cs_lattice_ppsnarg_processed_crs(r1cs_lattice_ppsnarg_processed_crs<ppT> &&other) = default;
+    r1cs_lattice_ppsnarg_processed_crs<ppT>& operator=(r1cs_lattice_ppsnarg_processed_crs<ppT> &&other) = default;
+
+    // The copy of the encrypted queries closest to the calling thread
+    const LWE::packed_ciphertexts& local_enc_queries() const
+    {
+        return enc_queries.size() == 1 ? enc_queries[0] : enc_queries[numa_current_node() % enc_queries.size()];
+    }
+};
+
+
 /******************************* Verification key ****************************/
 
 template<typename ppT>
@@ -89,11 +172,14 @@ class r1cs_lattice_ppsnarg_verification_key;
 
 /**
  * A verification key for the R1CS ppSNARG.
+ *
+ * The LWE secret key may be shared with the verification keys of other
+ * constraint systems (see r1cs_lattice_ppsnarg_multi_generator).
  */
 template<typename ppT>
 class r1cs_lattice_ppsnarg_verification_key {
 public:
-    LWE::secret_key sk;
+    std::shared_ptr<const LWE::secret_key> sk;
     libff::Fr_vector<ppT> Z;
     LWE::matrix Yprime;
 
@@ -101,22 +187,58 @@ public:
     std::vector<libff::Fr_vector<ppT>> B_prefix;
     std::vector<libff::Fr_vector<ppT>> C_prefix;
 
+    // The evaluation points of the queries (for incremental key generation)
+    libff::Fr_vector<ppT> t;
+
     r1cs_lattice_ppsnarg_verification_key() = default;
-    r1cs_lattice_ppsnarg_verification_key(LWE::secret_key &&sk,
+    r1cs_lattice_ppsnarg_verification_key(const std::shared_ptr<const LWE::secret_key> &sk,
                                           libff::Fr_vector<ppT> &&Z,
                                           LWE::matrix &&Yprime,
                                           std::vector<libff::Fr_vector<ppT>> &&A_prefix,
                                           std::vector<libff::Fr_vector<ppT>> &&B_prefix,
-                                          std::vector<libff::Fr_vector<ppT>> &&C_prefix) : 
-        sk(std::move(sk)),
+                                          std::vector<libff::Fr_vector<ppT>> &&C_prefix,
+                                          libff::Fr_vector<ppT> &&t) : 
+        sk(sk),
         Z(std::move(Z)),
         Yprime(std::move(Yprime)),
         A_prefix(std::move(A_prefix)),
         B_prefix(std::move(B_prefix)),
-        C_prefix(std::move(C_prefix))
+        C_prefix(std::move(C_prefix)),
+        t(std::move(t))
     {}
 };
 
+/************************ Processed verification key *************************/
+
+/**
+ * A processed verification key for the R1CS ppSNARG.
+ *
+ * Compared to a (non-processed) verification key, a processed verification key
+ * stores the decryption key and the verification tables in contiguous
+ * native-word layouts, so that the online verifier runs without converting
+ * NTL values or allocating memory. Processed verification keys with the same
+ * LWE secret key share the processed decryption key.
+ */
+template<typename ppT>
+class r1cs_lattice_ppsnarg_processed_verification_key {
+public:
+    std::shared_ptr<const LWE::processed_secret_key> psk;
+
+    // Yprime (4l x 4l), row-major
+    std::vector<uint32_t> Yprime;
+
+    // Z(t_i) for each query
+    std::vector<uint32_t> Z;
+
+    // Number of components in the prefixes (number of inputs + 1)
+    size_t prefix_size;
+
+    // A_prefix, B_prefix, C_prefix transposed (prefix_size x l), row-major
+    std::vector<uint32_t> A_prefix;
+    std::vector<uint32_t> B_prefix;
+    std::vector<uint32_t> C_prefix;
+};
+
 /********************************** Key pair *********************************/
 
 /**
@@ -155,7 +277,7 @@ public:
 
     r1cs_lattice_ppsnarg_proof() {}
     r1cs_lattice_ppsnarg_proof(LWE::ciphertext &&response) 
-        : response(response)
+        : response(std::move(response))
     {}
 };
 
@@ -171,6 +293,84 @@ public:
 template<typename ppT>
 r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const r1cs_lattice_ppsnarg_constraint_system<ppT> &cs);
 
+/**
+ * As above, but for a constraint system already in CSR layout. The CRS
+ * references cs instead of copying it.
+ */
+template<typename ppT>
+r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs);
+
+/**
+ * As above, but encrypts the queries under the given LWE secret key instead of
+ * a fresh one. The evaluation points, the linear shift Y and the encryption
+ * randomness are still drawn afresh.
+ */
+template<typename ppT>
+r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs,
+                                                                 const std::shared_ptr<const LWE::secret_key> &sk);
+
+/**
+ * As above, but encrypts the queries under the key of pool, with the
+ * encryptions of zero precomputed by the pool (see lwe_pool.hpp).
+ */
+template<typename ppT>
+r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs,
+                                                                 LWE::encryption_pool &pool);
+
+/**
+ * A generator algorithm for several R1CS constraint systems with the same
+ * (designated) verifier.
+ *
+ * This algorithm runs LWE::keygen once, and computes a key pair for each
+ * constraint system in css, with independent evaluation points, linear shifts
+ * and encryption randomness. The verification keys share the LWE secret key,
+ * so keygen time and verifier memory are amortized over the constraint
+ * systems. A verifier that leaks its decisions to a prover leaks them for all
+ * the constraint systems at once.
+ */
+template<typename ppT>
+std::vector<r1cs_lattice_ppsnarg_keypair<ppT> > r1cs_lattice_ppsnarg_multi_generator(const std::vector<std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > > &css);
+
+/**
+ * As above, but with the key of pool and its precomputed encryptions of zero.
+ */
+template<typename ppT>
+std::vector<r1cs_lattice_ppsnarg_keypair<ppT> > r1cs_lattice_ppsnarg_multi_generator(const std::vector<std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > > &css,
+                                                                                     LWE::encryption_pool &pool);
+
+/**
+ * An incremental generator algorithm for the R1CS ppSNARG.
+ *
+ * Given the key pair of a constraint system, and a constraint system cs that
+ * differs from it in the constraints changed_constraints (see
+ * r1cs_csr_changed_constraints), this algorithm computes a key pair for cs. It
+ * reuses the LWE key, the evaluation points and the linear shift Y of the old
+ * key pair, recomputes the query rows of the variables that appear in the
+ * changed constraints (in the old or the new constraint system), and encrypts
+ * only those rows. The other rows of the CRS are copied.
+ *
+ * This requires the same number of inputs and the same QAP domain (so that the
+ * Z(t) and H rows are unchanged); otherwise, it falls back to the generator,
+ * with the LWE key of keypair (and pool, if not null).
+ *
+ * The new key pair shares its secrets with the old one, so the old CRS should
+ * be retired: a prover holding both sees two encryptions of the queries at
+ * the same points.
+ *
+ * changed_constraints must include every constraint that differs between the
+ * two constraint systems (inserting or deleting a constraint changes all the
+ * later ones); otherwise, this throws std::runtime_error.
+ *
+ * If pool is not null, the rows are encrypted with its precomputed encryptions
+ * of zero; its key must be the one of keypair (otherwise, this throws
+ * std::runtime_error).
+ */
+template<typename ppT>
+r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_incremental_generator(const r1cs_lattice_ppsnarg_keypair<ppT> &keypair,
+                                                                             const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs,
+                                                                             const std::vector<size_t> &changed_constraints,
+                                                                             LWE::encryption_pool *pool = nullptr);
+
 /**
  * A prover algorithm for the R1CS ppSNARG.
  *
@@ -185,12 +385,64 @@ r1cs_lattice_ppsnarg_proof<ppT> r1cs_lattice_ppsnarg_prover(const r1cs_lattice_p
                                                             const r1cs_lattice_ppsnarg_auxiliary_input<ppT> &auxiliary_input);
 
 /**
- * A verifier algorithm for the R1CS ppSNARG
+ * Convert a (non-processed) CRS into a processed CRS with the given memory
+ * placement. This should be done once, when the CRS is loaded.
+ */
+template<typename ppT>
+r1cs_lattice_ppsnarg_processed_crs<ppT> r1cs_lattice_ppsnarg_prover_process_crs(const r1cs_lattice_ppsnarg_crs<ppT> &crs,
+                                                                                const r1cs_lattice_ppsnarg_crs_placement &placement = r1cs_lattice_ppsnarg_crs_placement());
+
+/**
+ * A prover algorithm for the R1CS ppSNARG that accepts a processed CRS. The
+ * proofs are the same as the ones of the prover.
+ */
+template<typename ppT>
+r1cs_lattice_ppsnarg_proof<ppT> r1cs_lattice_ppsnarg_online_prover(const r1cs_lattice_ppsnarg_processed_crs<ppT> &pcrs,
+                                                                   const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
+                                                                   const r1cs_lattice_ppsnarg_auxiliary_input<ppT> &auxiliary_input);
+
+/**
+ * The linear PCP proof vector computed by the prover: the coefficients (in
+ * [0, p)) of the linear combination of the encrypted queries in the CRS that
+ * forms the proof. Computing it needs only the constraint system, so it can be
+ * combined with the encrypted queries elsewhere (see r1cs_lattice_ppsnarg_sharded.hpp).
+ */
+template<typename ppT>
+std::vector<uint64_t> r1cs_lattice_ppsnarg_proof_vector(const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> &cs,
+                                                        const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
+                                                        const r1cs_lattice_ppsnarg_auxiliary_input<ppT> &auxiliary_input);
+
+/**
+ * A verifier algorithm for the R1CS ppSNARG that accepts a non-processed
+ * verification key.
  */
 template<typename ppT>
 bool r1cs_lattice_ppsnarg_verifier(const r1cs_lattice_ppsnarg_verification_key<ppT> &vk,
                                    const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
                                    const r1cs_lattice_ppsnarg_proof<ppT> &proof);
+
+/**
+ * Convert a (non-processed) verification key into a processed verification key.
+ * This should be done once, when the verification key is loaded.
+ */
+template<typename ppT>
+r1cs_lattice_ppsnarg_processed_verification_key<ppT> r1cs_lattice_ppsnarg_verifier_process_vk(const r1cs_lattice_ppsnarg_verification_key<ppT> &vk);
+
+/**
+ * Convert several verification keys (e.g. from the multi-circuit generator),
+ * processing each distinct LWE secret key only once.
+ */
+template<typename ppT>
+std::vector<r1cs_lattice_ppsnarg_processed_verification_key<ppT> > r1cs_lattice_ppsnarg_verifier_process_vks(const std::vector<r1cs_lattice_ppsnarg_verification_key<ppT> > &vks);
+
+/**
+ * A verifier algorithm for the R1CS ppSNARG that accepts a processed
+ * verification key. The online verifier does not allocate memory.
+ */
+template<typename ppT>
+bool r1cs_lattice_ppsnarg_online_verifier(const r1cs_lattice_ppsnarg_processed_verification_key<ppT> &pvk,
+                                          const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
+                                          const r1cs_lattice_ppsnarg_proof<ppT> &proof);
 } // libsnark
 
 #include <lattice_snarg/r1cs_lattice_snarg/r1cs_lattice_ppsnarg.tcc>
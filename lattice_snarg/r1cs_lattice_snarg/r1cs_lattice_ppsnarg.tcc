@@ -17,21 +17,28 @@ See r1cs_lattice_ppsnarg.hpp
 #include <cassert>
 #include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <inttypes.h>
 #include <NTL/mat_ZZ_p.h>
 
 #include <libff/common/profiling.hpp>
 #include <libff/common/utils.hpp>
+#include <libfqfft/evaluation_domain/get_evaluation_domain.hpp>
 
 #include <lattice_snarg/algebra/lattice/lwe.hpp>
-#include <libsnark/reductions/r1cs_to_qap/r1cs_to_qap.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_lincomb.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_pool.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_tuning.hpp>
+#include <lattice_snarg/r1cs_lattice_snarg/r1cs_csr_constraint_system.hpp>
 
 namespace libsnark {
 
 template<typename ppT>
 static LWE::matrix generate_Y(const int dim) {
-    NTL::ZZ_p::init(LWE::p);
+    NTL::ZZ_pPush push(LWE::p_context());
     LWE::matrix Y(NTL::INIT_SIZE, dim, dim);
 
     for (int i = 1; i <= dim; i++) {
@@ -55,7 +62,7 @@ static LWE::matrix make_query_matrix(const std::vector<libff::Fr_vector<ppT>> &A
     int rows = ABC_rows + 3 + H_query[0].size();
     int cols = LWE::l;
 
-    NTL::ZZ_p::init(LWE::p);
+    NTL::ZZ_pPush push(LWE::p_context());
     LWE::matrix mat(NTL::INIT_SIZE, rows, 4*cols);
     NTL::clear(mat);
 
@@ -90,26 +97,66 @@ static LWE::matrix make_query_matrix(const std::vector<libff::Fr_vector<ppT>> &A
     return mat;
 }
 
+// If pool is not null, its key must be sk. Otherwise, the encryption threads
+// of the tuning profile (if more than one, and NTL supports threads) fill a
+// pool for this call.
 static void encrypt_queries(std::vector<LWE::ciphertext> &enc_queries, 
-                     const LWE::secret_key &sk, const LWE::matrix &queries) {
+                     const std::shared_ptr<const LWE::secret_key> &sk, const LWE::matrix &queries,
+                     LWE::encryption_pool *pool) {
     int nrows = queries.NumRows();
 
+    const LWE::tuning_profile &profile = LWE::active_tuning_profile();
+    std::unique_ptr<LWE::encryption_pool> own_pool;
+    if (!pool && profile.encryption_threads > 1 && nrows > 1 && LWE::encryption_pool::threads_supported()) {
+        own_pool.reset(new LWE::encryption_pool(sk, std::min<size_t>(profile.encryption_batch, nrows), profile.encryption_threads));
+        pool = own_pool.get();
+    }
+
     enc_queries.resize(nrows);
     for (int i = 0; i < nrows; i++) {
-        enc_queries[i] = LWE::encrypt(sk, queries[i]);
+        enc_queries[i] = pool ? LWE::encrypt(*pool, queries[i]) : LWE::encrypt(*sk, queries[i]);
+    }
+
+    if (pool) {
+        libff::print_indent(); printf("* Encryption pool misses (since the pool started): %zu\n", pool->misses());
     }
 }
 
 template <typename ppT>
 r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const r1cs_lattice_ppsnarg_constraint_system<ppT> &cs) {
+    libff::enter_block("Convert constraint system to CSR layout");
+    const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > csr =
+        std::make_shared<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> >(cs);
+    libff::leave_block("Convert constraint system to CSR layout");
+
+    return r1cs_lattice_ppsnarg_generator<ppT>(csr);
+}
+
+template <typename ppT>
+r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs) {
+    libff::enter_block("Generate LWE secret key");
+    const std::shared_ptr<const LWE::secret_key> sk = std::make_shared<const LWE::secret_key>(LWE::keygen());
+    libff::leave_block("Generate LWE secret key");
+
+    return r1cs_lattice_ppsnarg_generator<ppT>(cs, sk);
+}
+
+template <typename ppT>
+static r1cs_lattice_ppsnarg_keypair<ppT> generate_keypair(const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs,
+                                                          const std::shared_ptr<const LWE::secret_key> &sk,
+                                                          LWE::encryption_pool *pool) {
     libff::enter_block("Call to r1cs_lattice_ppsnarg_generator");
 
+    // The queries, the linear shift Y and its inverse live in Z_p
+    NTL::ZZ_pPush push(LWE::p_context());
+
     std::vector<libff::Fr_vector<ppT>> A_queries(r1cs_lattice_ppsnarg_num_queries);
     std::vector<libff::Fr_vector<ppT>> B_queries(r1cs_lattice_ppsnarg_num_queries);
     std::vector<libff::Fr_vector<ppT>> C_queries(r1cs_lattice_ppsnarg_num_queries);
     std::vector<libff::Fr_vector<ppT>> H_queries(r1cs_lattice_ppsnarg_num_queries);
 
     libff::Fr_vector<ppT> Zs;
+    libff::Fr_vector<ppT> ts;
 
     // The first (num_inputs + 1) components of the A, B, and C queries. These
     // components are part of the verification state.
@@ -123,13 +170,18 @@ r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const r1cs_latt
         // Draw random field element for this query
         const libff::Fr<ppT> t = libff::Fr<ppT>::random_element();
 
-        qap_instance_evaluation<libff::Fr<ppT> > qap_inst = r1cs_to_qap_instance_map_with_evaluation(cs, t);
+        qap_instance_evaluation<libff::Fr<ppT> > qap_inst = r1cs_csr_to_qap_instance_map_with_evaluation(*cs, t);
 
         if (i == 0) {
             libff::print_indent(); printf("* QAP number of variables: %zu\n", qap_inst.num_variables());
-            libff::print_indent(); printf("* QAP pre degree: %zu\n", cs.constraints.size());
+            libff::print_indent(); printf("* QAP pre degree: %zu\n", cs->num_constraints());
             libff::print_indent(); printf("* QAP degree: %zu\n", qap_inst.degree());
             libff::print_indent(); printf("* QAP number of input variables: %zu\n", qap_inst.num_inputs());
+            libff::print_indent(); printf("* Constraint system size (CSR): %zu bytes\n", cs->size_in_bytes());
+
+            if (qap_inst.degree() > LWE::max_qap_degree) {
+                libff::print_indent(); printf("* WARNING: QAP degree exceeds %zu, the largest degree covered by the LWE parameters (see LWE_PARAMS)\n", LWE::max_qap_degree);
+            }
 
             num_inputs = qap_inst.num_inputs();
         }
@@ -140,6 +192,7 @@ r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const r1cs_latt
         H_queries[i] = std::move(qap_inst.Ht);
 
         Zs.emplace_back(qap_inst.Zt);
+        ts.emplace_back(t);
 
         for (size_t j = 0; j < num_inputs + 1; j++) {
             A_prefix[i].emplace_back(A_queries[i][j]);
@@ -157,24 +210,23 @@ r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const r1cs_latt
     libff::leave_block("Apply random linear shift to packed queries");
 
     libff::enter_block("Generate verification key");
-    LWE::secret_key sk = LWE::keygen();
-    NTL::ZZ_p::init(NTL::ZZ(LWE::p));
     LWE::matrix Yprime = NTL::inv(NTL::transpose(Y));
     libff::leave_block("Generate verification key");
    
     libff::enter_block("Generate CRS");
     std::vector<LWE::ciphertext> enc_queries;
-    encrypt_queries(enc_queries, sk, query_mat);
+    encrypt_queries(enc_queries, sk, query_mat, pool);
     libff::leave_block("Generate CRS");
 
     libff::leave_block("Call to r1cs_lattice_ppsnarg_generator");
 
-    r1cs_lattice_ppsnarg_verification_key<ppT> vk = r1cs_lattice_ppsnarg_verification_key<ppT>(std::move(sk),
+    r1cs_lattice_ppsnarg_verification_key<ppT> vk = r1cs_lattice_ppsnarg_verification_key<ppT>(sk,
                                                                                                    std::move(Zs),
                                                                                                    std::move(Yprime),
                                                                                                    std::move(A_prefix),
                                                                                                    std::move(B_prefix),
-                                                                                                   std::move(C_prefix));
+                                                                                                   std::move(C_prefix),
+                                                                                                   std::move(ts));
 
 
     r1cs_lattice_ppsnarg_crs<ppT> crs = r1cs_lattice_ppsnarg_crs<ppT>(std::move(enc_queries), cs);
@@ -183,13 +235,60 @@ r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const r1cs_latt
 }
 
 template <typename ppT>
-r1cs_lattice_ppsnarg_proof<ppT> r1cs_lattice_ppsnarg_prover(const r1cs_lattice_ppsnarg_crs<ppT> &crs,
-                                                const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
-                                                const r1cs_lattice_ppsnarg_auxiliary_input<ppT> &auxiliary_input) {
-    libff::enter_block("Call to r1cs_lattice_ppsnarg_prover");
+r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs,
+                                                                 const std::shared_ptr<const LWE::secret_key> &sk) {
+    return generate_keypair<ppT>(cs, sk, nullptr);
+}
+
+template <typename ppT>
+r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_generator(const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs,
+                                                                 LWE::encryption_pool &pool) {
+    return generate_keypair<ppT>(cs, pool.key(), &pool);
+}
+
+template <typename ppT>
+std::vector<r1cs_lattice_ppsnarg_keypair<ppT> > r1cs_lattice_ppsnarg_multi_generator(const std::vector<std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > > &css) {
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_multi_generator");
+    libff::print_indent(); printf("* Number of constraint systems: %zu\n", css.size());
+
+    libff::enter_block("Generate LWE secret key");
+    const std::shared_ptr<const LWE::secret_key> sk = std::make_shared<const LWE::secret_key>(LWE::keygen());
+    libff::leave_block("Generate LWE secret key");
+
+    std::vector<r1cs_lattice_ppsnarg_keypair<ppT> > keypairs;
+    keypairs.reserve(css.size());
+    for (const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs : css) {
+        keypairs.emplace_back(r1cs_lattice_ppsnarg_generator<ppT>(cs, sk));
+    }
+
+    libff::leave_block("Call to r1cs_lattice_ppsnarg_multi_generator");
+
+    return keypairs;
+}
+
+template <typename ppT>
+std::vector<r1cs_lattice_ppsnarg_keypair<ppT> > r1cs_lattice_ppsnarg_multi_generator(const std::vector<std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > > &css,
+                                                                                     LWE::encryption_pool &pool) {
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_multi_generator");
+    libff::print_indent(); printf("* Number of constraint systems: %zu\n", css.size());
+
+    std::vector<r1cs_lattice_ppsnarg_keypair<ppT> > keypairs;
+    keypairs.reserve(css.size());
+    for (const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs : css) {
+        keypairs.emplace_back(r1cs_lattice_ppsnarg_generator<ppT>(cs, pool));
+    }
+
+    libff::leave_block("Call to r1cs_lattice_ppsnarg_multi_generator");
 
+    return keypairs;
+}
+
+template <typename ppT>
+std::vector<uint64_t> r1cs_lattice_ppsnarg_proof_vector(const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> &cs,
+                                                        const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
+                                                        const r1cs_lattice_ppsnarg_auxiliary_input<ppT> &auxiliary_input) {
 #ifdef DEBUG
-    assert(crs.constraint_system.is_satisfied(primary_input, auxiliary_input));
+    assert(cs.is_satisfied(primary_input, auxiliary_input));
 #endif
 
     const libff::Fr<ppT> d1 = libff::Fr<ppT>::random_element(),
@@ -197,38 +296,189 @@ r1cs_lattice_ppsnarg_proof<ppT> r1cs_lattice_ppsnarg_prover(const r1cs_lattice_p
                          d3 = libff::Fr<ppT>::random_element();
 
     libff::enter_block("Compute the polynomial H");
-    const qap_witness<libff::Fr<ppT> > qap_wit = r1cs_to_qap_witness_map(crs.constraint_system, primary_input, auxiliary_input, d1, d2, d3);
+    const qap_witness<libff::Fr<ppT> > qap_wit = r1cs_csr_to_qap_witness_map(cs, primary_input, auxiliary_input, d1, d2, d3);
     libff::leave_block("Compute the polynomial H");
 
 #ifdef DEBUG
     const libff::Fr<ppT> t = libff::Fr<ppT>::random_element();
-    qap_instance_evaluation<libff::Fr<ppT> > qap_inst = r1cs_to_qap_instance_map_with_evaluation(crs.constraint_system, t);
+    qap_instance_evaluation<libff::Fr<ppT> > qap_inst = r1cs_csr_to_qap_instance_map_with_evaluation(cs, t);
     assert(qap_inst.is_satisfied(qap_wit));
 #endif
 
-    NTL::ZZ_p::init(NTL::ZZ(LWE::q));
-
-    libff::enter_block("Compute the proof");
-
     size_t num_inputs = qap_wit.num_inputs();
     size_t num_ABC_coeffs = qap_wit.coefficients_for_ABCs.size() - num_inputs;
     size_t proof_dim = num_ABC_coeffs + 3 + qap_wit.coefficients_for_H.size();
-    LWE::vector pi(NTL::INIT_SIZE, proof_dim);
+    std::vector<uint64_t> pi(proof_dim);
     for (size_t i = 0; i < num_ABC_coeffs; i++) {
-        pi[i] = qap_wit.coefficients_for_ABCs[i + num_inputs].as_ZZ_p();
+        pi[i] = qap_wit.coefficients_for_ABCs[i + num_inputs].as_ulong();
     }
-    pi[num_ABC_coeffs]     = qap_wit.d1.as_ZZ_p();
-    pi[num_ABC_coeffs + 1] = qap_wit.d2.as_ZZ_p();
-    pi[num_ABC_coeffs + 2] = qap_wit.d3.as_ZZ_p();
+    pi[num_ABC_coeffs]     = qap_wit.d1.as_ulong();
+    pi[num_ABC_coeffs + 1] = qap_wit.d2.as_ulong();
+    pi[num_ABC_coeffs + 2] = qap_wit.d3.as_ulong();
     for (size_t i = 0; i < qap_wit.coefficients_for_H.size(); i++) {
-        pi[num_ABC_coeffs + 3 + i] = qap_wit.coefficients_for_H[i].as_ZZ_p();
+        pi[num_ABC_coeffs + 3 + i] = qap_wit.coefficients_for_H[i].as_ulong();
     }
 
-    assert(proof_dim == crs.enc_queries.size());
-    LWE::ciphertext ct = crs.enc_queries[0] * pi[0];
-    for (size_t i = 1; i < proof_dim; i++) {
-        ct += crs.enc_queries[i] * pi[i];
+    return pi;
+}
+
+template <typename ppT>
+r1cs_lattice_ppsnarg_keypair<ppT> r1cs_lattice_ppsnarg_incremental_generator(const r1cs_lattice_ppsnarg_keypair<ppT> &keypair,
+                                                                             const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > &cs,
+                                                                             const std::vector<size_t> &changed_constraints,
+                                                                             LWE::encryption_pool *pool) {
+    if (pool && pool->key() != keypair.vk.sk) {
+        throw std::runtime_error("r1cs_lattice_ppsnarg_incremental_generator: the encryption pool uses another LWE secret key");
     }
+
+    const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> &old_cs = *keypair.crs.constraint_system;
+
+    // Inserting or deleting a constraint shifts the Lagrange index of every
+    // later one: a list that misses a changed constraint gives a CRS whose
+    // proofs do not verify
+    std::vector<size_t> listed = changed_constraints;
+    std::sort(listed.begin(), listed.end());
+    const std::vector<size_t> actual = r1cs_csr_changed_constraints(old_cs, *cs);
+    if (!std::includes(listed.begin(), listed.end(), actual.begin(), actual.end())) {
+        throw std::runtime_error("r1cs_lattice_ppsnarg_incremental_generator: changed_constraints misses a changed constraint");
+    }
+
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_incremental_generator");
+
+    const size_t num_inputs = cs->num_inputs();
+
+    // The Z and H rows of the CRS only depend on the QAP domain
+    const std::shared_ptr<libfqfft::evaluation_domain<libff::Fr<ppT> > > domain =
+        libfqfft::get_evaluation_domain<libff::Fr<ppT> >(cs->num_constraints() + num_inputs + 1);
+    const size_t old_num_ABC_rows = old_cs.num_variables() - old_cs.num_inputs();
+
+    bool same_domain = (old_cs.num_inputs() == num_inputs &&
+                        keypair.vk.t.size() == r1cs_lattice_ppsnarg_num_queries &&
+                        keypair.crs.enc_queries.size() == old_num_ABC_rows + 3 + domain->m + 1);
+    for (size_t i = 0; same_domain && i < r1cs_lattice_ppsnarg_num_queries; i++) {
+        same_domain = (domain->compute_vanishing_polynomial(keypair.vk.t[i]) == keypair.vk.Z[i]);
+    }
+    if (!same_domain) {
+        libff::print_indent(); printf("* Number of inputs or QAP domain changed: generating a new key pair\n");
+        libff::leave_block("Call to r1cs_lattice_ppsnarg_incremental_generator");
+        return generate_keypair<ppT>(cs, keypair.vk.sk, pool);
+    }
+
+    // The queries, the linear shift Y and its inverse live in Z_p
+    NTL::ZZ_pPush push(LWE::p_context());
+
+    libff::enter_block("Find variables of changed constraints");
+    // The prefixes (part of the verification key) are always recomputed: they
+    // also depend on the number of constraints
+    std::vector<size_t> vars;
+    for (size_t v = 0; v <= num_inputs; v++) {
+        vars.emplace_back(v);
+    }
+
+    std::vector<size_t> touched = r1cs_csr_constraint_variables(old_cs, changed_constraints);
+    const std::vector<size_t> touched_new = r1cs_csr_constraint_variables(*cs, changed_constraints);
+    touched.insert(touched.end(), touched_new.begin(), touched_new.end());
+    for (size_t v = old_cs.num_variables() + 1; v <= cs->num_variables(); v++) {
+        touched.emplace_back(v);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    for (size_t v : touched) {
+        if (v > num_inputs && v <= cs->num_variables()) {
+            vars.emplace_back(v);
+        }
+    }
+    const size_t num_changed_rows = vars.size() - (num_inputs + 1);
+    libff::leave_block("Find variables of changed constraints");
+
+    libff::enter_block("Recompute (packed) QAP queries of changed variables");
+    std::vector<libff::Fr_vector<ppT>> A_prefix(r1cs_lattice_ppsnarg_num_queries);
+    std::vector<libff::Fr_vector<ppT>> B_prefix(r1cs_lattice_ppsnarg_num_queries);
+    std::vector<libff::Fr_vector<ppT>> C_prefix(r1cs_lattice_ppsnarg_num_queries);
+
+    LWE::matrix changed_rows(NTL::INIT_SIZE, num_changed_rows, 4*LWE::l);
+    NTL::clear(changed_rows);
+
+    for (size_t i = 0; i < r1cs_lattice_ppsnarg_num_queries; i++) {
+        libff::Fr_vector<ppT> At, Bt, Ct;
+        r1cs_csr_evaluate_variables(*cs, keypair.vk.t[i], vars, At, Bt, Ct);
+
+        A_prefix[i].assign(At.begin(), At.begin() + num_inputs + 1);
+        B_prefix[i].assign(Bt.begin(), Bt.begin() + num_inputs + 1);
+        C_prefix[i].assign(Ct.begin(), Ct.begin() + num_inputs + 1);
+
+        for (size_t r = 0; r < num_changed_rows; r++) {
+            changed_rows[r][i]              = At[num_inputs + 1 + r].as_ZZ_p();
+            changed_rows[r][i + LWE::l]     = Bt[num_inputs + 1 + r].as_ZZ_p();
+            changed_rows[r][i + 2 * LWE::l] = Ct[num_inputs + 1 + r].as_ZZ_p();
+        }
+    }
+    libff::leave_block("Recompute (packed) QAP queries of changed variables");
+
+    libff::enter_block("Apply random linear shift to packed queries");
+    const LWE::matrix Y = NTL::transpose(NTL::inv(keypair.vk.Yprime));
+    changed_rows *= Y;
+    libff::leave_block("Apply random linear shift to packed queries");
+
+    libff::enter_block("Generate CRS");
+    std::vector<LWE::ciphertext> enc_changed_rows;
+    encrypt_queries(enc_changed_rows, keypair.vk.sk, changed_rows, pool);
+
+    const size_t num_ABC_rows = cs->num_variables() - num_inputs;
+    std::vector<LWE::ciphertext> enc_queries;
+    enc_queries.reserve(num_ABC_rows + 3 + domain->m + 1);
+
+    size_t next_changed = 0;
+    for (size_t r = 0; r < num_ABC_rows; r++) {
+        if (next_changed < num_changed_rows && vars[num_inputs + 1 + next_changed] == num_inputs + 1 + r) {
+            enc_queries.emplace_back(std::move(enc_changed_rows[next_changed++]));
+        } else {
+            enc_queries.emplace_back(keypair.crs.enc_queries[r]);
+        }
+    }
+    // The Z and H rows
+    enc_queries.insert(enc_queries.end(), keypair.crs.enc_queries.begin() + old_num_ABC_rows, keypair.crs.enc_queries.end());
+
+    libff::print_indent(); printf("* Changed constraints: %zu\n", changed_constraints.size());
+    libff::print_indent(); printf("* Encrypted CRS rows: %zu of %zu\n", num_changed_rows, enc_queries.size());
+    libff::leave_block("Generate CRS");
+
+    libff::leave_block("Call to r1cs_lattice_ppsnarg_incremental_generator");
+
+    libff::Fr_vector<ppT> Zs = keypair.vk.Z;
+    LWE::matrix Yprime = keypair.vk.Yprime;
+    libff::Fr_vector<ppT> ts = keypair.vk.t;
+
+    r1cs_lattice_ppsnarg_verification_key<ppT> vk = r1cs_lattice_ppsnarg_verification_key<ppT>(keypair.vk.sk,
+                                                                                                   std::move(Zs),
+                                                                                                   std::move(Yprime),
+                                                                                                   std::move(A_prefix),
+                                                                                                   std::move(B_prefix),
+                                                                                                   std::move(C_prefix),
+                                                                                                   std::move(ts));
+
+    r1cs_lattice_ppsnarg_crs<ppT> crs = r1cs_lattice_ppsnarg_crs<ppT>(std::move(enc_queries), cs);
+
+    return r1cs_lattice_ppsnarg_keypair<ppT>(std::move(crs), std::move(vk));
+}
+
+template <typename ppT>
+r1cs_lattice_ppsnarg_proof<ppT> r1cs_lattice_ppsnarg_prover(const r1cs_lattice_ppsnarg_crs<ppT> &crs,
+                                                const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
+                                                const r1cs_lattice_ppsnarg_auxiliary_input<ppT> &auxiliary_input) {
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_prover");
+
+    const std::vector<uint64_t> pi = r1cs_lattice_ppsnarg_proof_vector<ppT>(*crs.constraint_system, primary_input, auxiliary_input);
+
+    libff::enter_block("Compute the proof");
+    assert(pi.size() == crs.enc_queries.size());
+    const LWE::lincomb_plan plan = LWE::plan_linear_combination(pi);
+    if (!libff::inhibit_profiling_info) {
+        libff::print_indent(); printf("* Proof coefficients: %zu zero, %zu one, %zu other (%s strategy)\n",
+                                      plan.num_zero, plan.num_one, plan.num_other, LWE::lincomb_strategy_name(plan.strategy));
+    }
+    LWE::ciphertext ct = LWE::linear_combination(crs.enc_queries, pi, plan);
     libff::leave_block("Compute the proof");
 
     libff::leave_block("Call to r1cs_lattice_ppsnarg_prover");
@@ -238,54 +488,217 @@ r1cs_lattice_ppsnarg_proof<ppT> r1cs_lattice_ppsnarg_prover(const r1cs_lattice_p
     return proof;
 }
 
-template<typename ppT>
-bool r1cs_lattice_ppsnarg_verifier(const r1cs_lattice_ppsnarg_verification_key<ppT> &vk,
-                                     const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
-                                     const r1cs_lattice_ppsnarg_proof<ppT> &proof) {
-    bool result = true;
+template <typename ppT>
+r1cs_lattice_ppsnarg_processed_crs<ppT> r1cs_lattice_ppsnarg_prover_process_crs(const r1cs_lattice_ppsnarg_crs<ppT> &crs,
+                                                                                const r1cs_lattice_ppsnarg_crs_placement &placement) {
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_prover_process_crs");
 
-    libff::enter_block("Call to r1cs_lattice_ppsnarg_verifier");
+    r1cs_lattice_ppsnarg_processed_crs<ppT> pcrs;
+    pcrs.constraint_system = crs.constraint_system;
 
-    libff::enter_block("Decrypting proof");
-    LWE::vector proof_decrypt = vk.Yprime*LWE::decrypt(vk.sk, proof.response);
+    switch (placement.numa_policy) {
+        case r1cs_lattice_ppsnarg_crs_numa_policy::local:
+            pcrs.enc_queries.emplace_back(LWE::pack_ciphertexts(crs.enc_queries, placement.pages, numa_node_any));
+            break;
 
-    LWE::vector A(NTL::INIT_SIZE, r1cs_lattice_ppsnarg_num_queries);
-    LWE::vector B(NTL::INIT_SIZE, r1cs_lattice_ppsnarg_num_queries);
-    LWE::vector C(NTL::INIT_SIZE, r1cs_lattice_ppsnarg_num_queries);
-    LWE::vector H(NTL::INIT_SIZE, r1cs_lattice_ppsnarg_num_queries);
-    for (size_t i = 0; i < r1cs_lattice_ppsnarg_num_queries; i++) {
-        A[i] = proof_decrypt[i];
-        B[i] = proof_decrypt[i + r1cs_lattice_ppsnarg_num_queries];
-        C[i] = proof_decrypt[i + 2*r1cs_lattice_ppsnarg_num_queries];
-        H[i] = proof_decrypt[i + 3*r1cs_lattice_ppsnarg_num_queries];
-
-        // Add in components corresponding to the constant term as well as the
-        // components corresponding to the statement
-        A[i] += vk.A_prefix[i][0].as_ZZ_p();
-        B[i] += vk.B_prefix[i][0].as_ZZ_p();
-        C[i] += vk.C_prefix[i][0].as_ZZ_p();
-
-        for (size_t j = 0; j < primary_input.size(); j++) {
-            A[i] += primary_input[j].as_ZZ_p() * vk.A_prefix[i][j + 1].as_ZZ_p();
-            B[i] += primary_input[j].as_ZZ_p() * vk.B_prefix[i][j + 1].as_ZZ_p();
-            C[i] += primary_input[j].as_ZZ_p() * vk.C_prefix[i][j + 1].as_ZZ_p();
+        case r1cs_lattice_ppsnarg_crs_numa_policy::interleave:
+            pcrs.enc_queries.emplace_back(LWE::pack_ciphertexts(crs.enc_queries, placement.pages, numa_node_interleave));
+            break;
+
+        case r1cs_lattice_ppsnarg_crs_numa_policy::replicate:
+            for (size_t node = 0; node < numa_num_nodes(); node++) {
+                pcrs.enc_queries.emplace_back(LWE::pack_ciphertexts(crs.enc_queries, placement.pages, node));
+            }
+            break;
+    }
+
+    libff::print_indent(); printf("* Processed CRS: %zu cop%s of %zu bytes (%s pages)\n",
+                                  pcrs.enc_queries.size(), pcrs.enc_queries.size() == 1 ? "y" : "ies",
+                                  pcrs.enc_queries[0].buffer.size(), huge_pages_name(pcrs.enc_queries[0].buffer.pages()));
+
+    libff::leave_block("Call to r1cs_lattice_ppsnarg_prover_process_crs");
+
+    return pcrs;
+}
+
+template <typename ppT>
+r1cs_lattice_ppsnarg_proof<ppT> r1cs_lattice_ppsnarg_online_prover(const r1cs_lattice_ppsnarg_processed_crs<ppT> &pcrs,
+                                                                   const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
+                                                                   const r1cs_lattice_ppsnarg_auxiliary_input<ppT> &auxiliary_input) {
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_online_prover");
+
+    const std::vector<uint64_t> pi = r1cs_lattice_ppsnarg_proof_vector<ppT>(*pcrs.constraint_system, primary_input, auxiliary_input);
+
+    libff::enter_block("Compute the proof");
+    const LWE::packed_ciphertexts &enc_queries = pcrs.local_enc_queries();
+    assert(pi.size() == enc_queries.size());
+    LWE::ciphertext ct = LWE::linear_combination(enc_queries, pi);
+    libff::leave_block("Compute the proof");
+
+    libff::leave_block("Call to r1cs_lattice_ppsnarg_online_prover");
+
+    return r1cs_lattice_ppsnarg_proof<ppT>(std::move(ct));
+}
+
+template<typename ppT>
+static r1cs_lattice_ppsnarg_processed_verification_key<ppT> process_vk(const r1cs_lattice_ppsnarg_verification_key<ppT> &vk,
+                                                                       const std::shared_ptr<const LWE::processed_secret_key> &psk) {
+    r1cs_lattice_ppsnarg_processed_verification_key<ppT> pvk;
+    pvk.psk = psk;
+
+    const size_t dim = 4*r1cs_lattice_ppsnarg_num_queries;
+    pvk.Yprime.resize(dim * dim);
+    for (size_t i = 0; i < dim; i++) {
+        for (size_t j = 0; j < dim; j++) {
+            pvk.Yprime[i * dim + j] = NTL::conv<unsigned long>(NTL::rep(vk.Yprime[i][j]));
         }
     }
-    libff::leave_block("Decrypting proof");
 
-    libff::Fr_vector<ppT> Z = vk.Z;
+    pvk.Z.resize(r1cs_lattice_ppsnarg_num_queries);
+    for (size_t i = 0; i < r1cs_lattice_ppsnarg_num_queries; i++) {
+        pvk.Z[i] = vk.Z[i].as_ulong();
+    }
 
-    libff::enter_block("Check QAP divisibility");
-    NTL::ZZ_p::init(NTL::ZZ(LWE::p));
+    pvk.prefix_size = vk.A_prefix[0].size();
+    pvk.A_prefix.resize(pvk.prefix_size * r1cs_lattice_ppsnarg_num_queries);
+    pvk.B_prefix.resize(pvk.prefix_size * r1cs_lattice_ppsnarg_num_queries);
+    pvk.C_prefix.resize(pvk.prefix_size * r1cs_lattice_ppsnarg_num_queries);
     for (size_t i = 0; i < r1cs_lattice_ppsnarg_num_queries; i++) {
-        if (A[i]*B[i] != H[i]*Z[i].as_ZZ_p() + C[i]) {
+        for (size_t j = 0; j < pvk.prefix_size; j++) {
+            pvk.A_prefix[j * r1cs_lattice_ppsnarg_num_queries + i] = vk.A_prefix[i][j].as_ulong();
+            pvk.B_prefix[j * r1cs_lattice_ppsnarg_num_queries + i] = vk.B_prefix[i][j].as_ulong();
+            pvk.C_prefix[j * r1cs_lattice_ppsnarg_num_queries + i] = vk.C_prefix[i][j].as_ulong();
+        }
+    }
+
+    return pvk;
+}
+
+template<typename ppT>
+r1cs_lattice_ppsnarg_processed_verification_key<ppT> r1cs_lattice_ppsnarg_verifier_process_vk(const r1cs_lattice_ppsnarg_verification_key<ppT> &vk) {
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_verifier_process_vk");
+
+    const std::shared_ptr<const LWE::processed_secret_key> psk =
+        std::make_shared<const LWE::processed_secret_key>(LWE::process_secret_key(*vk.sk));
+    r1cs_lattice_ppsnarg_processed_verification_key<ppT> pvk = process_vk<ppT>(vk, psk);
+
+    libff::leave_block("Call to r1cs_lattice_ppsnarg_verifier_process_vk");
+
+    return pvk;
+}
+
+template<typename ppT>
+std::vector<r1cs_lattice_ppsnarg_processed_verification_key<ppT> > r1cs_lattice_ppsnarg_verifier_process_vks(const std::vector<r1cs_lattice_ppsnarg_verification_key<ppT> > &vks) {
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_verifier_process_vks");
+
+    std::map<const LWE::secret_key*, std::shared_ptr<const LWE::processed_secret_key> > psks;
+
+    std::vector<r1cs_lattice_ppsnarg_processed_verification_key<ppT> > pvks;
+    pvks.reserve(vks.size());
+    for (const r1cs_lattice_ppsnarg_verification_key<ppT> &vk : vks) {
+        std::shared_ptr<const LWE::processed_secret_key> &psk = psks[vk.sk.get()];
+        if (!psk) {
+            psk = std::make_shared<const LWE::processed_secret_key>(LWE::process_secret_key(*vk.sk));
+        }
+        pvks.emplace_back(process_vk<ppT>(vk, psk));
+    }
+
+    libff::print_indent(); printf("* Distinct LWE secret keys: %zu\n", psks.size());
+    libff::leave_block("Call to r1cs_lattice_ppsnarg_verifier_process_vks");
+
+    return pvks;
+}
+
+template<typename ppT>
+bool r1cs_lattice_ppsnarg_online_verifier(const r1cs_lattice_ppsnarg_processed_verification_key<ppT> &pvk,
+                                          const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
+                                          const r1cs_lattice_ppsnarg_proof<ppT> &proof) {
+    const size_t l = r1cs_lattice_ppsnarg_num_queries;
+
+    if (primary_input.size() + 1 != pvk.prefix_size) {
+        if (!libff::inhibit_profiling_info) {
+            libff::print_indent(); printf("Primary input has the wrong length.\n");
+        }
+        return false;
+    }
+
+    if (proof.response.ctxt.length() != LWE::ct_dim) {
+        if (!libff::inhibit_profiling_info) {
+            libff::print_indent(); printf("Proof response has the wrong length.\n");
+        }
+        return false;
+    }
+
+    // Decrypt the proof and undo the random linear shift
+    uint64_t proof_decrypt[LWE::pt_dim];
+    uint64_t proof_shifted[LWE::pt_dim];
+    LWE::decrypt(*pvk.psk, proof.response, proof_shifted);
+    LWE::mat_vec_mod_p(pvk.Yprime.data(), proof_shifted, proof_decrypt, LWE::pt_dim, LWE::pt_dim);
+
+    const uint64_t *A = proof_decrypt;
+    const uint64_t *B = proof_decrypt + l;
+    const uint64_t *C = proof_decrypt + 2*l;
+    const uint64_t *H = proof_decrypt + 3*l;
+
+    // Add in components corresponding to the constant term as well as the
+    // components corresponding to the statement
+    uint64_t A_in[r1cs_lattice_ppsnarg_num_queries];
+    uint64_t B_in[r1cs_lattice_ppsnarg_num_queries];
+    uint64_t C_in[r1cs_lattice_ppsnarg_num_queries];
+    for (size_t i = 0; i < l; i++) {
+        A_in[i] = A[i] + pvk.A_prefix[i];
+        B_in[i] = B[i] + pvk.B_prefix[i];
+        C_in[i] = C[i] + pvk.C_prefix[i];
+    }
+
+    size_t j = 0;
+    while (j < primary_input.size()) {
+        const size_t end = std::min<size_t>(primary_input.size(), j + LWE::lazy_reduction_batch - 1);
+        for (; j < end; j++) {
+            const uint64_t x = primary_input[j].as_ulong();
+            const uint32_t *A_row = &pvk.A_prefix[(j + 1) * l];
+            const uint32_t *B_row = &pvk.B_prefix[(j + 1) * l];
+            const uint32_t *C_row = &pvk.C_prefix[(j + 1) * l];
+            for (size_t i = 0; i < l; i++) {
+                A_in[i] += x * A_row[i];
+                B_in[i] += x * B_row[i];
+                C_in[i] += x * C_row[i];
+            }
+        }
+
+        for (size_t i = 0; i < l; i++) {
+            A_in[i] %= LWE::p_int;
+            B_in[i] %= LWE::p_int;
+            C_in[i] %= LWE::p_int;
+        }
+    }
+
+    // Check QAP divisibility
+    bool result = true;
+    for (size_t i = 0; i < l; i++) {
+        const uint64_t lhs = ((A_in[i] % LWE::p_int) * (B_in[i] % LWE::p_int)) % LWE::p_int;
+        const uint64_t rhs = (H[i] * pvk.Z[i] + C_in[i] % LWE::p_int) % LWE::p_int;
+        if (lhs != rhs) {
             if (!libff::inhibit_profiling_info) {
                 libff::print_indent(); printf("QAP divisiblity check failed.\n");
             }
             result = false;
         }
     }
-    libff::leave_block("Check QAP divisibility");
+
+    return result;
+}
+
+template<typename ppT>
+bool r1cs_lattice_ppsnarg_verifier(const r1cs_lattice_ppsnarg_verification_key<ppT> &vk,
+                                   const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
+                                   const r1cs_lattice_ppsnarg_proof<ppT> &proof) {
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_verifier");
+    const r1cs_lattice_ppsnarg_processed_verification_key<ppT> pvk = r1cs_lattice_ppsnarg_verifier_process_vk<ppT>(vk);
+
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_online_verifier");
+    const bool result = r1cs_lattice_ppsnarg_online_verifier<ppT>(pvk, primary_input, proof);
+    libff::leave_block("Call to r1cs_lattice_ppsnarg_online_verifier");
 
     libff::leave_block("Call to r1cs_lattice_ppsnarg_verifier");
     return result;
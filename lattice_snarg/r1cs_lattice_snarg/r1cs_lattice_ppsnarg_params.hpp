@@ -12,6 +12,7 @@
 #define R1CS_LATTICE_PPSNARG_PARAMS_HPP_
 
 #include <libsnark/relations/constraint_satisfaction_problems/r1cs/r1cs.hpp>
+#include <lattice_snarg/r1cs_lattice_snarg/r1cs_csr_constraint_system.hpp>
 
 namespace libsnark {
 
@@ -22,6 +23,9 @@ namespace libsnark {
 template<typename ppT>
 using r1cs_lattice_ppsnarg_constraint_system = r1cs_constraint_system<libff::Fr<ppT> >;
 
+template<typename ppT>
+using r1cs_lattice_ppsnarg_csr_constraint_system = r1cs_csr_constraint_system<libff::Fr<ppT> >;
+
 template<typename ppT>
 using r1cs_lattice_ppsnarg_primary_input = r1cs_primary_input<libff::Fr<ppT> >;
 
@@ -0,0 +1,141 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of interfaces for proving with a CRS that is split into shards
+ held by separate worker processes (possibly on separate machines).
+
+ The proof is the linear combination sum_i pi[i] * enc_queries[i] of the
+ encrypted queries in the CRS, where pi is the linear PCP proof vector (see
+ r1cs_lattice_ppsnarg_proof_vector). Since the combination is linear, the CRS
+ can be split into contiguous ranges of encrypted queries (shards): each worker
+ loads only its shard, and returns the partial combination over its range; the
+ coordinator computes pi (which only needs the constraint system) and sums the
+ partial ciphertexts. The proof is identical to the one computed by the
+ single-process prover.
+
+ The coordinator talks to each worker over a pair of file descriptors (see
+ fd_channel.hpp). A request is [offset][count][count coefficients], all as
+ 64-bit little-endian integers, and asks for the combination of the count
+ encrypted queries starting at index offset of the full CRS. A response is a
+ status byte (0 on success) followed by the serialized partial ciphertext.
+
+ This includes:
+ - class for a CRS shard
+ - splitting a CRS into shards
+ - worker and coordinator algorithms
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef R1CS_LATTICE_PPSNARG_SHARDED_HPP_
+#define R1CS_LATTICE_PPSNARG_SHARDED_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include <lattice_snarg/r1cs_lattice_snarg/r1cs_lattice_ppsnarg.hpp>
+
+namespace libsnark {
+
+/********************************* CRS shard *********************************/
+
+template<typename ppT>
+class r1cs_lattice_ppsnarg_crs_shard;
+
+template<typename ppT>
+std::ostream& operator<<(std::ostream &out, const r1cs_lattice_ppsnarg_crs_shard<ppT> &shard);
+
+template<typename ppT>
+std::istream& operator>>(std::istream &in, r1cs_lattice_ppsnarg_crs_shard<ppT> &shard);
+
+/**
+ * A contiguous range of the encrypted queries of a CRS, starting at index
+ * offset of the full CRS.
+ */
+template<typename ppT>
+class r1cs_lattice_ppsnarg_crs_shard {
+public:
+    size_t offset;
+    std::vector<LWE::ciphertext> enc_queries;
+
+    r1cs_lattice_ppsnarg_crs_shard() : offset(0) {};
+    r1cs_lattice_ppsnarg_crs_shard(size_t offset, std::vector<LWE::ciphertext> &&enc_queries) :
+        offset(offset),
+        enc_queries(std::move(enc_queries))
+    {};
+
+    size_t size() const { return enc_queries.size(); }
+
+    friend std::ostream& operator<< <ppT>(std::ostream &out, const r1cs_lattice_ppsnarg_crs_shard<ppT> &shard);
+    friend std::istream& operator>> <ppT>(std::istream &in, r1cs_lattice_ppsnarg_crs_shard<ppT> &shard);
+};
+
+/**
+ * Split the encrypted queries of crs into num_shards shards of (nearly) equal
+ * size.
+ */
+template<typename ppT>
+std::vector<r1cs_lattice_ppsnarg_crs_shard<ppT> > r1cs_lattice_ppsnarg_crs_split(const r1cs_lattice_ppsnarg_crs<ppT> &crs,
+                                                                                  size_t num_shards);
+
+/********************************** Workers **********************************/
+
+/**
+ * The partial combination sum_{i < count} coeffs[i] * enc_queries[offset + i]
+ * over a range of the full CRS, which must lie within the shard.
+ */
+template<typename ppT>
+LWE::ciphertext r1cs_lattice_ppsnarg_shard_response(const r1cs_lattice_ppsnarg_crs_shard<ppT> &shard,
+                                                    size_t offset,
+                                                    const std::vector<uint64_t> &coeffs);
+
+/**
+ * Serve requests read from in_fd with the responses written to out_fd, until
+ * in_fd is closed. Returns false if a request is malformed or a write fails.
+ */
+template<typename ppT>
+bool r1cs_lattice_ppsnarg_shard_worker(const r1cs_lattice_ppsnarg_crs_shard<ppT> &shard,
+                                       int in_fd,
+                                       int out_fd);
+
+/******************************** Coordinator ********************************/
+
+/**
+ * The coordinator's end of the connection to a worker holding the shard that
+ * starts at index offset and has size encrypted queries.
+ */
+class r1cs_lattice_ppsnarg_shard_channel {
+public:
+    int request_fd;
+    int response_fd;
+    size_t offset;
+    size_t size;
+
+    r1cs_lattice_ppsnarg_shard_channel(int request_fd, int response_fd, size_t offset, size_t size) :
+        request_fd(request_fd),
+        response_fd(response_fd),
+        offset(offset),
+        size(size)
+    {};
+};
+
+/**
+ * A prover that computes the proof vector locally and the linear combination
+ * on the workers. The shards of the workers must cover the CRS exactly once.
+ * Throws std::runtime_error if a worker fails.
+ */
+template<typename ppT>
+r1cs_lattice_ppsnarg_proof<ppT> r1cs_lattice_ppsnarg_sharded_prover(const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> &cs,
+                                                                    const std::vector<r1cs_lattice_ppsnarg_shard_channel> &workers,
+                                                                    const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
+                                                                    const r1cs_lattice_ppsnarg_auxiliary_input<ppT> &auxiliary_input);
+
+} // libsnark
+
+#include <lattice_snarg/r1cs_lattice_snarg/r1cs_lattice_ppsnarg_sharded.tcc>
+
+#endif // R1CS_LATTICE_PPSNARG_SHARDED_HPP_
@@ -0,0 +1,240 @@
+/** @file
+*****************************************************************************
+
+Implementation of interfaces for proving with a sharded CRS.
+
+See r1cs_lattice_ppsnarg_sharded.hpp
+
+*****************************************************************************
+* @author     Samir Menon, Brennan Shacklett, and David J. Wu
+* @copyright  MIT license (see LICENSE file)
+*****************************************************************************/
+
+#ifndef R1CS_LATTICE_PPSNARG_SHARDED_TCC_
+#define R1CS_LATTICE_PPSNARG_SHARDED_TCC_
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <libff/common/profiling.hpp>
+#include <libff/common/utils.hpp>
+
+#include <lattice_snarg/algebra/lattice/lwe_lincomb.hpp>
+#include <lattice_snarg/common/fd_channel.hpp>
+
+namespace libsnark {
+
+template<typename ppT>
+std::ostream& operator<<(std::ostream &out, const r1cs_lattice_ppsnarg_crs_shard<ppT> &shard)
+{
+    std::string header;
+    append_uint64(header, shard.offset);
+    append_uint64(header, shard.enc_queries.size());
+    out.write(header.data(), header.size());
+
+    for (const LWE::ciphertext &ct : shard.enc_queries) {
+        out << ct;
+    }
+
+    return out;
+}
+
+template<typename ppT>
+std::istream& operator>>(std::istream &in, r1cs_lattice_ppsnarg_crs_shard<ppT> &shard)
+{
+    std::string header(16, '\0');
+    in.read(&header[0], header.size());
+    shard.offset = parse_uint64(header, 0);
+
+    // The count comes from the stream: read the ciphertexts one at a time
+    // (until the stream ends) instead of allocating them up front
+    const uint64_t count = in ? parse_uint64(header, 8) : 0;
+    shard.enc_queries.clear();
+    for (uint64_t i = 0; i < count && in; i++) {
+        shard.enc_queries.emplace_back();
+        in >> shard.enc_queries.back();
+    }
+
+    return in;
+}
+
+template<typename ppT>
+std::vector<r1cs_lattice_ppsnarg_crs_shard<ppT> > r1cs_lattice_ppsnarg_crs_split(const r1cs_lattice_ppsnarg_crs<ppT> &crs,
+                                                                                  size_t num_shards)
+{
+    assert(num_shards > 0);
+
+    const size_t total = crs.enc_queries.size();
+    std::vector<r1cs_lattice_ppsnarg_crs_shard<ppT> > shards;
+    shards.reserve(num_shards);
+
+    size_t begin = 0;
+    for (size_t s = 0; s < num_shards; s++) {
+        // The first (total mod num_shards) shards get one extra query
+        const size_t end = begin + total / num_shards + (s < total % num_shards ? 1 : 0);
+        std::vector<LWE::ciphertext> enc_queries(crs.enc_queries.begin() + begin, crs.enc_queries.begin() + end);
+        shards.emplace_back(begin, std::move(enc_queries));
+        begin = end;
+    }
+
+    return shards;
+}
+
+template<typename ppT>
+LWE::ciphertext r1cs_lattice_ppsnarg_shard_response(const r1cs_lattice_ppsnarg_crs_shard<ppT> &shard,
+                                                    size_t offset,
+                                                    const std::vector<uint64_t> &coeffs)
+{
+    assert(offset >= shard.offset && offset + coeffs.size() <= shard.offset + shard.size());
+
+    // Queries of the shard outside the requested range get coefficient 0,
+    // which the linear combination skips
+    std::vector<uint64_t> shard_coeffs(shard.size(), 0);
+    std::copy(coeffs.begin(), coeffs.end(), shard_coeffs.begin() + (offset - shard.offset));
+
+    const LWE::lincomb_plan plan = LWE::plan_linear_combination(shard_coeffs);
+    return LWE::linear_combination(shard.enc_queries, shard_coeffs, plan);
+}
+
+template<typename ppT>
+bool r1cs_lattice_ppsnarg_shard_worker(const r1cs_lattice_ppsnarg_crs_shard<ppT> &shard,
+                                       int in_fd,
+                                       int out_fd)
+{
+    // A request is an offset, a count, and at most one coefficient per query
+    // of the shard
+    const uint64_t max_request = 16 + 8 * (uint64_t) shard.size();
+
+    std::string request;
+    while (true) {
+        errno = 0;
+        if (!read_message(in_fd, request, max_request)) {
+            if (errno == EMSGSIZE) {
+                write_message(out_fd, std::string(1, '\1'));
+                return false;
+            }
+            break;
+        }
+
+        const size_t count = (request.size() >= 16) ? parse_uint64(request, 8) : 0;
+        const size_t offset = (request.size() >= 16) ? parse_uint64(request, 0) : 0;
+
+        const bool well_formed = (request.size() >= 16 &&
+                                  (request.size() - 16) / 8 == count &&
+                                  (request.size() - 16) % 8 == 0 &&
+                                  offset >= shard.offset &&
+                                  count <= shard.size() &&
+                                  offset - shard.offset <= shard.size() - count);
+        if (!well_formed) {
+            write_message(out_fd, std::string(1, '\1'));
+            return false;
+        }
+
+        std::vector<uint64_t> coeffs(count);
+        bool in_range = true;
+        for (size_t i = 0; i < count; i++) {
+            coeffs[i] = parse_uint64(request, 16 + 8 * i);
+            in_range = in_range && (coeffs[i] < LWE::p_int);
+        }
+        if (!in_range) {
+            write_message(out_fd, std::string(1, '\1'));
+            return false;
+        }
+
+        std::ostringstream response;
+        response.put('\0');
+        response << r1cs_lattice_ppsnarg_shard_response<ppT>(shard, offset, coeffs);
+        if (!write_message(out_fd, response.str())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename ppT>
+r1cs_lattice_ppsnarg_proof<ppT> r1cs_lattice_ppsnarg_sharded_prover(const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> &cs,
+                                                                    const std::vector<r1cs_lattice_ppsnarg_shard_channel> &workers,
+                                                                    const r1cs_lattice_ppsnarg_primary_input<ppT> &primary_input,
+                                                                    const r1cs_lattice_ppsnarg_auxiliary_input<ppT> &auxiliary_input)
+{
+    libff::enter_block("Call to r1cs_lattice_ppsnarg_sharded_prover");
+
+    const std::vector<uint64_t> pi = r1cs_lattice_ppsnarg_proof_vector<ppT>(cs, primary_input, auxiliary_input);
+
+    // The shards must partition [0, pi.size()): sorted by offset, each one
+    // starts where the previous one ends
+    std::vector<std::pair<size_t, size_t> > ranges;
+    for (const r1cs_lattice_ppsnarg_shard_channel &worker : workers) {
+        if (worker.offset > pi.size() || worker.size > pi.size() - worker.offset) {
+            throw std::runtime_error("r1cs_lattice_ppsnarg_sharded_prover: shard out of range of the CRS");
+        }
+        ranges.emplace_back(worker.offset, worker.size);
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    size_t covered = 0;
+    for (const std::pair<size_t, size_t> &range : ranges) {
+        if (range.first != covered) {
+            throw std::runtime_error("r1cs_lattice_ppsnarg_sharded_prover: shards overlap or leave a gap in the CRS");
+        }
+        covered += range.second;
+    }
+    if (covered != pi.size()) {
+        throw std::runtime_error("r1cs_lattice_ppsnarg_sharded_prover: shards do not cover the CRS");
+    }
+
+    // Send all requests first, so that the workers compute concurrently
+    libff::enter_block("Send requests to workers");
+    for (const r1cs_lattice_ppsnarg_shard_channel &worker : workers) {
+        std::string request;
+        request.reserve(16 + 8 * worker.size);
+        append_uint64(request, worker.offset);
+        append_uint64(request, worker.size);
+        for (size_t i = 0; i < worker.size; i++) {
+            append_uint64(request, pi[worker.offset + i]);
+        }
+
+        if (!write_message(worker.request_fd, request)) {
+            throw std::runtime_error("r1cs_lattice_ppsnarg_sharded_prover: failed to send request to worker");
+        }
+    }
+    libff::leave_block("Send requests to workers");
+
+    libff::enter_block("Combine partial proofs");
+    LWE::ciphertext ct;
+    for (size_t w = 0; w < workers.size(); w++) {
+        std::string response;
+        if (!read_message(workers[w].response_fd, response, 1 + LWE::ct_bytes) || response.empty() || response[0] != '\0') {
+            throw std::runtime_error("r1cs_lattice_ppsnarg_sharded_prover: worker failed");
+        }
+
+        std::istringstream in(response.substr(1));
+        LWE::ciphertext partial;
+        in >> partial;
+        if (!in) {
+            throw std::runtime_error("r1cs_lattice_ppsnarg_sharded_prover: malformed response from worker");
+        }
+
+        if (w == 0) {
+            ct = std::move(partial);
+        } else {
+            ct += partial;
+        }
+    }
+    libff::leave_block("Combine partial proofs");
+
+    libff::leave_block("Call to r1cs_lattice_ppsnarg_sharded_prover");
+
+    return r1cs_lattice_ppsnarg_proof<ppT>(std::move(ct));
+}
+
+} // libsnark
+
+#endif // R1CS_LATTICE_PPSNARG_SHARDED_TCC_
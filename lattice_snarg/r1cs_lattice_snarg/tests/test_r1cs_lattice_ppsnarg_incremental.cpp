@@ -0,0 +1,161 @@
+/** @file
+ *****************************************************************************
+
+ Test program that changes one constraint of an example R1CS instance, updates
+ the key pair with the incremental generator, and checks that the proof for
+ the new constraint system verifies, and that the CRS rows of the variables
+ outside the changed constraint were reused. It also inserts and deletes a
+ constraint (which changes all the later ones), checks that an incomplete list
+ of changed constraints is rejected, and changes the QAP domain (which falls
+ back to the generator with the same LWE key).
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <libff/common/profiling.hpp>
+#include <libff/common/utils.hpp>
+
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+#include <lattice_snarg/algebra/lattice/lattice_pp.hpp>
+#include <lattice_snarg/r1cs_lattice_snarg/r1cs_lattice_ppsnarg.hpp>
+
+using namespace libsnark;
+
+// Update keypair to new_cs with the incremental generator, and check that the
+// new key pair keeps the LWE key and that its proofs verify
+template<typename ppT>
+bool check_incremental_update(const r1cs_lattice_ppsnarg_keypair<ppT> &keypair,
+                              const r1cs_constraint_system<libff::Fr<ppT> > &new_cs,
+                              const r1cs_example<libff::Fr<ppT> > &example,
+                              const char *name) {
+    const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > new_csr =
+        std::make_shared<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> >(new_cs);
+    const std::vector<size_t> changed_constraints = r1cs_csr_changed_constraints(*keypair.crs.constraint_system, *new_csr);
+
+    const r1cs_lattice_ppsnarg_keypair<ppT> new_keypair = r1cs_lattice_ppsnarg_incremental_generator<ppT>(keypair, new_csr, changed_constraints);
+
+    bool res = true;
+    if (new_keypair.vk.sk != keypair.vk.sk) {
+        printf("* %s: the new key pair has another LWE key\n", name);
+        res = false;
+    }
+
+    const r1cs_lattice_ppsnarg_proof<ppT> proof = r1cs_lattice_ppsnarg_prover<ppT>(new_keypair.crs, example.primary_input, example.auxiliary_input);
+    if (!r1cs_lattice_ppsnarg_verifier<ppT>(new_keypair.vk, example.primary_input, proof)) {
+        printf("* %s: proof for the changed constraint system does not verify\n", name);
+        res = false;
+    }
+
+    return res;
+}
+
+template<typename ppT>
+bool test_r1cs_lattice_ppsnarg_incremental(size_t num_constraints, size_t input_size) {
+    libff::print_header("(enter) Test R1CS lattice ppSNARG with incremental key generation");
+
+    r1cs_example<libff::Fr<ppT> > example = generate_r1cs_example_with_field_input<libff::Fr<ppT> >(num_constraints, input_size);
+    const r1cs_lattice_ppsnarg_keypair<ppT> keypair = r1cs_lattice_ppsnarg_generator<ppT>(example.constraint_system);
+
+    // Scaling both sides of a constraint keeps the assignment satisfying
+    const size_t changed = num_constraints / 2;
+    r1cs_constraint_system<libff::Fr<ppT> > new_cs = example.constraint_system;
+    new_cs.constraints[changed].a = new_cs.constraints[changed].a * libff::Fr<ppT>(2);
+    new_cs.constraints[changed].c = new_cs.constraints[changed].c * libff::Fr<ppT>(2);
+
+    const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > new_csr =
+        std::make_shared<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> >(new_cs);
+
+    bool res = true;
+    const std::vector<size_t> changed_constraints = r1cs_csr_changed_constraints(*keypair.crs.constraint_system, *new_csr);
+    if (changed_constraints != std::vector<size_t>(1, changed)) {
+        printf("* Wrong set of changed constraints\n");
+        res = false;
+    }
+
+    const r1cs_lattice_ppsnarg_keypair<ppT> new_keypair = r1cs_lattice_ppsnarg_incremental_generator<ppT>(keypair, new_csr, changed_constraints);
+
+    const r1cs_lattice_ppsnarg_proof<ppT> proof = r1cs_lattice_ppsnarg_prover<ppT>(new_keypair.crs, example.primary_input, example.auxiliary_input);
+    if (!r1cs_lattice_ppsnarg_verifier<ppT>(new_keypair.vk, example.primary_input, proof)) {
+        printf("* Proof for the changed constraint system does not verify\n");
+        res = false;
+    }
+
+    // Only the rows of the variables of the changed constraint are re-encrypted
+    const std::vector<size_t> vars = r1cs_csr_constraint_variables(*new_csr, changed_constraints);
+    const size_t num_inputs = new_csr->num_inputs();
+    size_t num_reused = 0;
+    for (size_t r = 0; r < keypair.crs.enc_queries.size(); r++) {
+        std::ostringstream before, after;
+        before << keypair.crs.enc_queries[r];
+        after << new_keypair.crs.enc_queries[r];
+
+        const size_t var = num_inputs + 1 + r;
+        const bool touched = (var <= new_csr->num_variables() && std::binary_search(vars.begin(), vars.end(), var));
+        if (touched == (before.str() == after.str())) {
+            printf("* CRS row %zu was %s\n", r, touched ? "not re-encrypted" : "re-encrypted");
+            res = false;
+        }
+        num_reused += touched ? 0 : 1;
+    }
+    printf("* Reused CRS rows: %zu of %zu\n", num_reused, keypair.crs.enc_queries.size());
+
+    // Inserting a copy of the first constraint in the middle shifts the later
+    // constraints
+    r1cs_constraint_system<libff::Fr<ppT> > inserted_cs = example.constraint_system;
+    const r1cs_constraint<libff::Fr<ppT> > first = inserted_cs.constraints[0];
+    inserted_cs.constraints.insert(inserted_cs.constraints.begin() + changed, first);
+    res = check_incremental_update<ppT>(keypair, inserted_cs, example, "Inserted constraint") && res;
+
+    // Only listing the inserted constraint is rejected
+    const std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > inserted_csr =
+        std::make_shared<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> >(inserted_cs);
+    try {
+        r1cs_lattice_ppsnarg_incremental_generator<ppT>(keypair, inserted_csr, std::vector<size_t>(1, changed));
+        printf("* Incomplete list of changed constraints accepted\n");
+        res = false;
+    } catch (const std::runtime_error &) {
+    }
+
+    // Deleting a constraint in the middle
+    r1cs_constraint_system<libff::Fr<ppT> > deleted_cs = example.constraint_system;
+    deleted_cs.constraints.erase(deleted_cs.constraints.begin() + changed);
+    res = check_incremental_update<ppT>(keypair, deleted_cs, example, "Deleted constraint") && res;
+
+    // Repeating every constraint doubles the QAP domain
+    r1cs_constraint_system<libff::Fr<ppT> > doubled_cs = example.constraint_system;
+    doubled_cs.constraints.insert(doubled_cs.constraints.end(),
+                                  example.constraint_system.constraints.begin(), example.constraint_system.constraints.end());
+    res = check_incremental_update<ppT>(keypair, doubled_cs, example, "Changed QAP domain") && res;
+
+    if (!res) {
+        libff::print_header("TEST FAILED");
+    }
+
+    libff::print_header("(leave) Test R1CS lattice ppSNARG with incremental key generation");
+
+    return res;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cout << "usage: ./test_r1cs_lattice_ppsnarg_incremental n_constraints n_inputs" << std::endl;
+        return -1;
+    }
+
+    lattice_pp::init_public_params();
+    libff::start_profiling();
+
+    const bool res = test_r1cs_lattice_ppsnarg_incremental<lattice_pp>(atoi(argv[1]), atoi(argv[2]));
+
+    return res ? 0 : 1;
+}
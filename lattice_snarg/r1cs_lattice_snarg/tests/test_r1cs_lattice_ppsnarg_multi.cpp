@@ -0,0 +1,89 @@
+/** @file
+ *****************************************************************************
+
+ Test program that sets up several example R1CS instances with the
+ multi-circuit generator, and checks that the verification keys share one LWE
+ secret key, that each proof verifies under the verification key of its own
+ constraint system, and not under the one of another constraint system.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <libff/common/profiling.hpp>
+#include <libff/common/utils.hpp>
+
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+#include <lattice_snarg/algebra/lattice/lattice_pp.hpp>
+#include <lattice_snarg/r1cs_lattice_snarg/r1cs_lattice_ppsnarg.hpp>
+
+using namespace libsnark;
+
+template<typename ppT>
+bool test_r1cs_lattice_ppsnarg_multi(size_t num_constraints, size_t input_size, size_t num_circuits) {
+    libff::print_header("(enter) Test R1CS lattice ppSNARG with a shared LWE key");
+
+    std::vector<r1cs_example<libff::Fr<ppT> > > examples;
+    std::vector<std::shared_ptr<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> > > css;
+    for (size_t i = 0; i < num_circuits; i++) {
+        examples.emplace_back(generate_r1cs_example_with_field_input<libff::Fr<ppT> >(num_constraints + i, input_size));
+        css.emplace_back(std::make_shared<const r1cs_lattice_ppsnarg_csr_constraint_system<ppT> >(examples[i].constraint_system));
+    }
+
+    const std::vector<r1cs_lattice_ppsnarg_keypair<ppT> > keypairs = r1cs_lattice_ppsnarg_multi_generator<ppT>(css);
+
+    std::vector<r1cs_lattice_ppsnarg_verification_key<ppT> > vks;
+    for (const r1cs_lattice_ppsnarg_keypair<ppT> &keypair : keypairs) {
+        vks.emplace_back(keypair.vk);
+    }
+    const std::vector<r1cs_lattice_ppsnarg_processed_verification_key<ppT> > pvks = r1cs_lattice_ppsnarg_verifier_process_vks<ppT>(vks);
+
+    bool res = true;
+    for (size_t i = 0; i < num_circuits; i++) {
+        if (keypairs[i].vk.sk != keypairs[0].vk.sk || pvks[i].psk != pvks[0].psk) {
+            printf("* Circuit %zu does not share the LWE secret key\n", i);
+            res = false;
+        }
+
+        const r1cs_lattice_ppsnarg_proof<ppT> proof = r1cs_lattice_ppsnarg_prover<ppT>(keypairs[i].crs, examples[i].primary_input, examples[i].auxiliary_input);
+        if (!r1cs_lattice_ppsnarg_online_verifier<ppT>(pvks[i], examples[i].primary_input, proof)) {
+            printf("* Proof for circuit %zu does not verify\n", i);
+            res = false;
+        }
+
+        // The queries of each circuit are drawn independently
+        const size_t other = (i + 1) % num_circuits;
+        if (other != i && r1cs_lattice_ppsnarg_online_verifier<ppT>(pvks[other], examples[i].primary_input, proof)) {
+            printf("* Proof for circuit %zu verifies for circuit %zu\n", i, other);
+            res = false;
+        }
+    }
+
+    if (!res) {
+        libff::print_header("TEST FAILED");
+    }
+
+    libff::print_header("(leave) Test R1CS lattice ppSNARG with a shared LWE key");
+
+    return res;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4 || atoi(argv[3]) < 1) {
+        std::cout << "usage: ./test_r1cs_lattice_ppsnarg_multi n_constraints n_inputs n_circuits" << std::endl;
+        return -1;
+    }
+
+    lattice_pp::init_public_params();
+    libff::start_profiling();
+
+    const bool res = test_r1cs_lattice_ppsnarg_multi<lattice_pp>(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]));
+
+    return res ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+/** @file
+ *****************************************************************************
+
+ Test program that splits the CRS of the ppSNARG into shards, starts one
+ worker process per shard (each of which loads only its shard from disk), and
+ checks that the proof computed by the sharded prover verifies and equals the
+ combination computed by the single-process prover. It also checks that
+ malformed shard layouts, requests and shard files are rejected.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include <libff/common/profiling.hpp>
+#include <libff/common/utils.hpp>
+
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+#include <lattice_snarg/algebra/lattice/lattice_pp.hpp>
+#include <lattice_snarg/algebra/lattice/lwe_lincomb.hpp>
+#include <lattice_snarg/r1cs_lattice_snarg/r1cs_lattice_ppsnarg_sharded.hpp>
+
+using namespace libsnark;
+
+template<typename ppT>
+bool test_r1cs_lattice_ppsnarg_sharded(size_t num_constraints, size_t input_size, size_t num_shards) {
+    libff::print_header("(enter) Test R1CS lattice ppSNARG with a sharded CRS");
+
+    r1cs_example<libff::Fr<ppT> > example = generate_r1cs_example_with_field_input<libff::Fr<ppT> >(num_constraints, input_size);
+    const r1cs_lattice_ppsnarg_keypair<ppT> keypair = r1cs_lattice_ppsnarg_generator<ppT>(example.constraint_system);
+
+    libff::enter_block("Write CRS shards");
+    const std::vector<r1cs_lattice_ppsnarg_crs_shard<ppT> > shards = r1cs_lattice_ppsnarg_crs_split<ppT>(keypair.crs, num_shards);
+    std::vector<std::string> shard_files;
+    for (size_t s = 0; s < num_shards; s++) {
+        shard_files.push_back("/tmp/r1cs_lattice_ppsnarg_shard_" + std::to_string(getpid()) + "_" + std::to_string(s));
+        std::ofstream out(shard_files[s], std::ios::binary);
+        out << shards[s];
+    }
+    libff::leave_block("Write CRS shards");
+
+    libff::enter_block("Start workers");
+    std::vector<r1cs_lattice_ppsnarg_shard_channel> workers;
+    std::vector<pid_t> pids;
+    for (size_t s = 0; s < num_shards; s++) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            perror("socketpair");
+            return false;
+        }
+
+        const pid_t pid = fork();
+        if (pid == 0) {
+            // Close the coordinator's ends of the earlier workers' sockets, so
+            // that those workers see end of file when the coordinator is done.
+            // The worker reads its shard back from disk.
+            for (const r1cs_lattice_ppsnarg_shard_channel &worker : workers) {
+                close(worker.request_fd);
+            }
+            close(fds[0]);
+
+            libff::inhibit_profiling_info = true;
+            r1cs_lattice_ppsnarg_crs_shard<ppT> shard;
+            std::ifstream in(shard_files[s], std::ios::binary);
+            in >> shard;
+            const bool ok = in && r1cs_lattice_ppsnarg_shard_worker<ppT>(shard, fds[1], fds[1]);
+            _exit(ok ? 0 : 1);
+        }
+
+        close(fds[1]);
+        pids.push_back(pid);
+        // The coordinator only needs the shard boundaries
+        workers.emplace_back(fds[0], fds[0], shards[s].offset, shards[s].size());
+    }
+    libff::leave_block("Start workers");
+
+    bool res = true;
+    const r1cs_lattice_ppsnarg_proof<ppT> proof = r1cs_lattice_ppsnarg_sharded_prover<ppT>(*keypair.crs.constraint_system, workers,
+                                                                                           example.primary_input, example.auxiliary_input);
+    if (!r1cs_lattice_ppsnarg_verifier<ppT>(keypair.vk, example.primary_input, proof)) {
+        printf("* Sharded proof does not verify\n");
+        res = false;
+    }
+
+    // With fixed proof coefficients, the sharded and unsharded combinations agree
+    {
+        std::vector<uint64_t> coeffs(keypair.crs.enc_queries.size());
+        for (size_t i = 0; i < coeffs.size(); i++) {
+            coeffs[i] = (i * 7919 + 1) % LWE::p_int;
+        }
+
+        std::ostringstream expected, combined;
+        expected << LWE::linear_combination(keypair.crs.enc_queries, coeffs, LWE::plan_linear_combination(coeffs));
+
+        LWE::ciphertext ct = r1cs_lattice_ppsnarg_shard_response<ppT>(shards[0], 0, std::vector<uint64_t>(coeffs.begin(), coeffs.begin() + shards[0].size()));
+        for (size_t s = 1; s < num_shards; s++) {
+            const size_t begin = shards[s].offset;
+            ct += r1cs_lattice_ppsnarg_shard_response<ppT>(shards[s], begin, std::vector<uint64_t>(coeffs.begin() + begin, coeffs.begin() + begin + shards[s].size()));
+        }
+        combined << ct;
+
+        if (expected.str() != combined.str()) {
+            printf("* Sharded combination differs from the unsharded one\n");
+            res = false;
+        }
+    }
+
+    // Overlapping shards with a gap (the sizes still add up to the CRS size)
+    // are rejected before any request is sent
+    {
+        const size_t num = keypair.crs.enc_queries.size();
+        const size_t half = num / 2;
+        std::vector<r1cs_lattice_ppsnarg_shard_channel> overlapping;
+        overlapping.emplace_back(-1, -1, 0, half);
+        overlapping.emplace_back(-1, -1, half - 2, num - half);
+
+        bool rejected = false;
+        try {
+            r1cs_lattice_ppsnarg_sharded_prover<ppT>(*keypair.crs.constraint_system, overlapping,
+                                                     example.primary_input, example.auxiliary_input);
+        } catch (const std::runtime_error &) {
+            rejected = true;
+        }
+        if (!rejected) {
+            printf("* Overlapping shards were accepted\n");
+            res = false;
+        }
+    }
+
+    // A request header announcing more bytes than any valid request is
+    // rejected without reading (or allocating) the body
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            perror("socketpair");
+            return false;
+        }
+        std::string header;
+        append_uint64(header, UINT64_MAX);
+        const ssize_t written = write(fds[0], header.data(), header.size());
+        if (written != (ssize_t) header.size() || r1cs_lattice_ppsnarg_shard_worker<ppT>(shards[0], fds[1], fds[1])) {
+            printf("* Oversized request was accepted\n");
+            res = false;
+        }
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    // A truncated shard whose header announces a huge number of queries
+    {
+        std::string truncated;
+        append_uint64(truncated, 0);
+        append_uint64(truncated, UINT64_MAX);
+        std::istringstream in(truncated);
+        r1cs_lattice_ppsnarg_crs_shard<ppT> shard;
+        in >> shard;
+        if (in) {
+            printf("* Truncated shard was accepted\n");
+            res = false;
+        }
+    }
+
+    for (size_t s = 0; s < num_shards; s++) {
+        close(workers[s].request_fd);
+
+        int status = 0;
+        waitpid(pids[s], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            printf("* Worker %zu failed\n", s);
+            res = false;
+        }
+        unlink(shard_files[s].c_str());
+    }
+
+    if (!res) {
+        libff::print_header("TEST FAILED");
+    }
+
+    libff::print_header("(leave) Test R1CS lattice ppSNARG with a sharded CRS");
+
+    return res;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4 || atoi(argv[3]) < 1) {
+        std::cout << "usage: ./test_r1cs_lattice_ppsnarg_sharded n_constraints n_inputs n_shards" << std::endl;
+        return -1;
+    }
+
+    lattice_pp::init_public_params();
+    libff::start_profiling();
+
+    const bool res = test_r1cs_lattice_ppsnarg_sharded<lattice_pp>(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]));
+
+    return res ? 0 : 1;
+}
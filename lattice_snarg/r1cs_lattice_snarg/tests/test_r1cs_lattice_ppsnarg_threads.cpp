@@ -0,0 +1,106 @@
+/** @file
+ *****************************************************************************
+
+ Stress test that runs many provers and verifiers of the ppSNARG concurrently
+ on different threads of one process, sharing one (processed) CRS and one
+ (processed) verification key. Online provers are pinned to NUMA nodes (if
+ supported) and read the CRS copy on their node.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <libff/common/profiling.hpp>
+#include <libff/common/utils.hpp>
+
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+#include <lattice_snarg/algebra/lattice/lattice_pp.hpp>
+#include <lattice_snarg/r1cs_lattice_snarg/r1cs_lattice_ppsnarg.hpp>
+
+using namespace libsnark;
+
+template<typename ppT>
+bool test_r1cs_lattice_ppsnarg_threads(size_t num_constraints, size_t input_size,
+                                       size_t num_threads, size_t num_iterations) {
+    libff::print_header("(enter) Test R1CS lattice ppSNARG with concurrent provers and verifiers");
+
+    r1cs_example<libff::Fr<ppT> > example = generate_r1cs_example_with_field_input<libff::Fr<ppT> >(num_constraints, input_size);
+    const r1cs_lattice_ppsnarg_keypair<ppT> keypair = r1cs_lattice_ppsnarg_generator<ppT>(example.constraint_system);
+    const r1cs_lattice_ppsnarg_processed_verification_key<ppT> pvk = r1cs_lattice_ppsnarg_verifier_process_vk<ppT>(keypair.vk);
+    const r1cs_lattice_ppsnarg_processed_crs<ppT> pcrs =
+        r1cs_lattice_ppsnarg_prover_process_crs<ppT>(keypair.crs, r1cs_lattice_ppsnarg_crs_placement(huge_pages::huge_2mb,
+                                                                                                     r1cs_lattice_ppsnarg_crs_numa_policy::replicate));
+
+    // A statement that the proofs do not attest to
+    r1cs_lattice_ppsnarg_primary_input<ppT> wrong_input = example.primary_input;
+    if (!wrong_input.empty()) {
+        wrong_input[0] += libff::Fr<ppT>::one();
+    }
+
+    // From here on, libff's profiling state must not be touched
+    libff::inhibit_profiling_info = true;
+    libff::inhibit_profiling_counters = true;
+
+    std::atomic<size_t> failures(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            const r1cs_lattice_ppsnarg_proof<ppT> proof = r1cs_lattice_ppsnarg_prover<ppT>(keypair.crs, example.primary_input, example.auxiliary_input);
+
+            numa_pin_thread_to_node(t % numa_num_nodes());
+            const r1cs_lattice_ppsnarg_proof<ppT> online_proof = r1cs_lattice_ppsnarg_online_prover<ppT>(pcrs, example.primary_input, example.auxiliary_input);
+            if (!r1cs_lattice_ppsnarg_online_verifier<ppT>(pvk, example.primary_input, online_proof)) {
+                failures++;
+            }
+
+            for (size_t it = 0; it < num_iterations; it++) {
+                if (!r1cs_lattice_ppsnarg_online_verifier<ppT>(pvk, example.primary_input, proof)) {
+                    failures++;
+                }
+                if (!wrong_input.empty() && r1cs_lattice_ppsnarg_online_verifier<ppT>(pvk, wrong_input, proof)) {
+                    failures++;
+                }
+            }
+
+            if (!r1cs_lattice_ppsnarg_verifier<ppT>(keypair.vk, example.primary_input, proof)) {
+                failures++;
+            }
+        });
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    libff::inhibit_profiling_info = false;
+    libff::inhibit_profiling_counters = false;
+
+    printf("* %zu threads x %zu verifications: %zu failures\n", num_threads, num_iterations, failures.load());
+    if (failures != 0) {
+        libff::print_header("TEST FAILED");
+    }
+
+    libff::print_header("(leave) Test R1CS lattice ppSNARG with concurrent provers and verifiers");
+
+    return (failures == 0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 5) {
+        std::cout << "usage: ./test_r1cs_lattice_ppsnarg_threads n_constraints n_inputs n_threads n_iterations" << std::endl;
+        return -1;
+    }
+
+    lattice_pp::init_public_params();
+    libff::start_profiling();
+
+    const bool res = test_r1cs_lattice_ppsnarg_threads<lattice_pp>(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+
+    return res ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+/** @file
+ *****************************************************************************
+
+ Tool that benchmarks the LWE kernels (encryption, accumulation, decryption)
+ on the current host with the compiled LWE parameters, and saves the fastest
+ settings to a tuning profile (see lwe_tuning.hpp). To use the profile, set
+ LATTICE_SNARG_PROFILE to its path.
+
+ *****************************************************************************
+ * @author     Samir Menon, Brennan Shacklett, and David J. Wu
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <lattice_snarg/algebra/lattice/lwe_tuning.hpp>
+
+static void usage() {
+    std::cout << "usage: ./lattice_snarg_tune [--output FILE] [--max-threads N] [--rows N] [--quick]" << std::endl
+              << "  --output FILE     profile to write (default: lattice_snarg.profile)" << std::endl
+              << "  --max-threads N   largest number of threads to try (default: all hardware threads)" << std::endl
+              << "  --rows N          packed ciphertexts in the accumulation benchmark (default: 4096)" << std::endl
+              << "  --quick           shorter measurements" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::string output = "lattice_snarg.profile";
+    LWE::tuning_options options;
+
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = (i + 1 < argc);
+        if (strcmp(argv[i], "--output") == 0 && has_value) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--max-threads") == 0 && has_value && atoi(argv[i + 1]) > 0) {
+            options.max_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rows") == 0 && has_value && atoi(argv[i + 1]) > 0) {
+            options.num_rows = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            options.min_time = 0.05;
+            options.encryptions_per_thread = 2;
+        } else {
+            usage();
+            return -1;
+        }
+    }
+
+    const LWE::tuning_profile profile = LWE::tune_profile(options, std::cout);
+
+    std::ofstream out(output);
+    LWE::write_tuning_profile(out, profile);
+    out.close();
+    if (!out) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << output << "; to use it, set LATTICE_SNARG_PROFILE=" << output << std::endl;
+    return 0;
+}